@@ -36,10 +36,23 @@ extern size_t maxWorkItems (int dim);
  *
  * allocDev : returns an openCL device memory identifier for device memory 
  *            of "n" bytes.
+ *            Buffers come from a pool of size classes (n rounded up to an
+ *            eighth of its leading power of two): a buffer given back with
+ *            releaseDev is reused by the next request of the same class.
+ *            setupKernel gives back the buffers of the previous setup, and
+ *            freeDevice releases everything, including the pool.
  *
  ******************************************************************************/
 extern cl_mem allocDev( size_t n);
 
+/*******************************************************************************
+ *
+ * releaseDev : gives a buffer obtained from allocDev back to the pool.
+ *              Buffers that wrap host memory are released right away.
+ *
+ ******************************************************************************/
+extern void releaseDev( cl_mem mem);
+
 /*******************************************************************************
  *
  * host2devDoubleArr : transfers "n" elements of the double array "a" on the host
@@ -88,6 +101,14 @@ extern void dev2hostBoolArr( cl_mem ad, bool *a, size_t n);
  *               - the kernel source as a string
  *               - the name of the kernel function as string
  *
+ *                The program is only built once per source: further kernels
+ *                from the same source share it. Program binaries are cached
+ *                on disk, keyed by a hash of the source, the build options,
+ *                the device name and the driver version, so later runs skip
+ *                the compilation. The cache lives in the directory named by
+ *                the environment variable HEAT_CL_CACHE (default ".clcache");
+ *                setting it to the empty string disables the cache.
+ *
  ******************************************************************************/
 extern cl_kernel createKernel( const char *kernel_source, char *kernel_name);
 
@@ -159,6 +180,72 @@ extern cl_int launchKernel( cl_kernel kernel, int dim, size_t *global, size_t *l
 
 extern cl_int runKernel( cl_kernel kernel, int dim, size_t *global, size_t *local);
 
+/*******************************************************************************
+ *
+ * setTransferPolicy : this routine declares when argument <arg> (counted as in
+ *                     the kernel signature) of the previous call to setupKernel
+ *                     is copied back to the host by runKernelSelective:
+ *    TransferAlways   : after every launch (the default, as in runKernel)
+ *    TransferEveryK   : after every <k>-th launch since setupKernel
+ *    TransferOnDemand : only when fetchArg is called for it
+ *    TransferAtEnd    : only when fetchFinal is called
+ *    TransferNever    : never
+ *                     Every call to setupKernel resets all arguments to
+ *                     TransferAlways. <k> is ignored unless the policy is
+ *                     TransferEveryK.
+ *
+ ******************************************************************************/
+
+typedef enum {
+  TransferAlways,
+  TransferEveryK,
+  TransferOnDemand,
+  TransferAtEnd,
+  TransferNever
+} transfer_policy;
+
+extern void setTransferPolicy( int arg, transfer_policy policy, int k);
+
+/*******************************************************************************
+ *
+ * runKernelSelective : this routine is similar to runKernel.
+ *             However, it only copies back those arguments whose transfer
+ *             policy (see setTransferPolicy) asks for it after this launch.
+ *
+ ******************************************************************************/
+
+extern cl_int runKernelSelective( cl_kernel kernel, int dim, size_t *global, size_t *local);
+
+/*******************************************************************************
+ *
+ * fetchArg : copies argument <arg> of the previous call to setupKernel back
+ *            to its host buffer now, regardless of its transfer policy.
+ *
+ ******************************************************************************/
+
+extern void fetchArg( int arg);
+
+/*******************************************************************************
+ *
+ * fetchFinal : copies back all arguments with policy TransferAtEnd or
+ *              TransferEveryK, so that the host buffers hold the final
+ *              results once the last runKernelSelective has been issued.
+ *
+ ******************************************************************************/
+
+extern void fetchFinal();
+
+/*******************************************************************************
+ *
+ * releaseKernelArgs : gives the device buffers allocated by the previous
+ *                     call to setupKernel back to the pool. setupKernel does
+ *                     this itself before allocating new ones.
+ *                     The kernels themselves must be released separately.
+ *
+ ******************************************************************************/
+
+extern void releaseKernelArgs();
+
 /*******************************************************************************
  *
  * printKernelTime : we internally measure the wallclock time that elapses
@@ -170,6 +257,16 @@ extern cl_int runKernel( cl_kernel kernel, int dim, size_t *global, size_t *loca
  *                   launchKernel and runKernel. It does not matter how much
  *                   time elapses between the last call to runKernel and the
  *                   call to printKernelTime!
+ *                   It also prints how many device buffers were requested,
+ *                   how many of them came from the pool and the peak number
+ *                   of bytes held by live buffers.
+ *                   If the environment variable HEAT_CL_PROFILE is set to a
+ *                   value other than "0" when the device is initialised, the
+ *                   command queue is created with CL_QUEUE_PROFILING_ENABLE and
+ *                   every kernel launch, write, read and copy is profiled as
+ *                   well. This routine then also prints, per command type, the
+ *                   summed queued->submit, submit->start and start->end times,
+ *                   which tells the launch overhead apart from the compute.
  *
  ******************************************************************************/
 
@@ -155,18 +155,22 @@ int main()
    if (err == CL_SUCCESS) {
       clock_gettime(1, &start);
       kernels = setupKernel(KernelSource, "relax", 5, DoubleArr, n, a, DoubleArr, n, b, BoolArr, n, stable, DoubleConst, EPS, IntConst, n);
+      // only the stability flags are needed on the host while iterating
+      setTransferPolicy(0, TransferAtEnd, 0);
+      setTransferPolicy(1, TransferAtEnd, 0);
 
       do {         
          if (count == 0) {
-            runKernel(kernels.kernel1, 1, global, local);
+            runKernelSelective(kernels.kernel1, 1, global, local);
             count++;
          } else {
-            runKernel(kernels.kernel2, 1, global, local);
+            runKernelSelective(kernels.kernel2, 1, global, local);
             count--;
          }
          
          iterations++;
       } while(!isStable(stable, n));
+      fetchFinal();
       
       clock_gettime(1, &stop);
       
@@ -0,0 +1,235 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <math.h>
+#include <string.h>
+#include <CL/cl.h>
+#include <time.h>
+
+#include "simple.h"
+
+#define NX 2048      // width of the plate
+#define NY 2048      // height of the plate
+#define EPS 0.1      // convergence criterium
+#define HEAT 100.0   // heat value on the top edge
+
+#define TILE_X 16    // work group width
+#define TILE_Y 16    // work group height
+#define PITCH 32     // rows start at multiples of PITCH doubles (256 bytes)
+
+struct timespec start, stop;
+
+void printTimeElapsed(char *text)
+{
+  double elapsed = (stop.tv_sec -start.tv_sec)*1000.0
+                  + (double)(stop.tv_nsec -start.tv_nsec)/1000000.0;
+  printf( "%s: %f msec\n", text, elapsed);
+}
+
+//
+// row pitch in doubles for a plate of width "nx": rows are padded to a
+// multiple of PITCH so that every row starts on an aligned address and the
+// loads of a work group row coalesce
+//
+int rowPitch(int nx)
+{
+   return ((nx + PITCH - 1) / PITCH) * PITCH;
+}
+
+//
+// allocate a plate of "ny" rows of "pitch" doubles
+//
+double *allocPlate(int pitch, int ny)
+{
+   double *v;
+   v = (double *)malloc( (size_t)pitch*ny*sizeof(double));
+   return v;
+}
+
+//
+// initialise the plate "out" of "nx" x "ny" cells with row pitch "pitch":
+// the top edge is held at HEAT, everything else (including the padding at
+// the end of the rows) is 0
+//
+void init(double *out, int nx, int ny, int pitch)
+{
+   int x, y;
+
+   for(y=0; y<ny; y++) {
+      for(x=0; x<pitch; x++) {
+         out[y*pitch + x] = (y == 0 && x < nx) ? HEAT : 0;
+      }
+   }
+}
+
+//
+// print the values of a given plate "out" of "nx" x "ny" cells
+//
+void print(double *out, int nx, int ny, int pitch)
+{
+   int x, y;
+
+   for( y=0; y<ny; y++) {
+      printf("<");
+      for( x=0; x<nx; x++) {
+         printf(" %f", out[y*pitch + x]);
+      }
+      printf(">\n");
+   }
+}
+
+//
+// checks the convergence criterion for the last sweep: true, iff no work
+// group found a cell with |out - in| > eps
+//
+bool isStable(int *record)
+{
+   return record[0] == 0;
+}
+
+//
+//relax function in kernel source: one five-point Jacobi sweep over a 2D
+//plate, in 2D work groups. Each group loads its tile plus a one cell halo
+//into local memory, so every cell of "in" is read from global memory about
+//once. The tile is reused for the residual reduction, as in Attempt 2.
+//
+const char *KernelSource =                                                                 "\n"
+  "__kernel void relax(                                                                    \n"
+  "   __local  double* tile,                                                               \n"
+  "   __global double* in,                                                                 \n"
+  "   __global double* out,                                                                \n"
+  "   __global int* record,                                                                \n"
+  "   const double eps,                                                                    \n"
+  "   const unsigned int nx,                                                               \n"
+  "   const unsigned int ny,                                                               \n"
+  "   const unsigned int pitch)                                                            \n"
+  "{                                                                                       \n"
+  "   int x = get_global_id(0);                                                            \n"
+  "   int y = get_global_id(1);                                                            \n"
+  "   int wx = get_local_size(0);                                                          \n"
+  "   int wy = get_local_size(1);                                                          \n"
+  "   int wg_size = wx * wy;                                                               \n"
+  "   int wg_i = get_local_id(1) * wx + get_local_id(0);                                   \n"
+  "   int tw = wx + 2;                                                                     \n"
+  "   int x0 = get_group_id(0) * wx - 1;                                                   \n"
+  "   int y0 = get_group_id(1) * wy - 1;                                                   \n"
+  "   int c = (get_local_id(1) + 1) * tw + get_local_id(0) + 1;                            \n"
+  "   double res = 0.0;                                                                    \n"
+  "   double v;                                                                            \n"
+  "                                                                                        \n"
+  "   for (int t = wg_i; t < tw * (wy + 2); t += wg_size) {                                \n"
+  "      int tx = x0 + t % tw;                                                             \n"
+  "      int ty = y0 + t / tw;                                                             \n"
+  "      if (tx >= 0 && tx < nx && ty >= 0 && ty < ny)                                     \n"
+  "         tile[t] = in[ty * pitch + tx];                                                 \n"
+  "      else                                                                              \n"
+  "         tile[t] = 0.0;                                                                 \n"
+  "   }                                                                                    \n"
+  "   barrier(CLK_LOCAL_MEM_FENCE);                                                        \n"
+  "                                                                                        \n"
+  "   if (x < nx && y < ny) {                                                              \n"
+  "      if (x > 0 && x < nx-1 && y > 0 && y < ny-1) {                                     \n"
+  "         v = 0.5*tile[c] + 0.125*(tile[c-1] + tile[c+1] + tile[c-tw] + tile[c+tw]);     \n"
+  "      } else {                                                                          \n"
+  "         v = tile[c];                                                                   \n"
+  "      }                                                                                 \n"
+  "      out[y * pitch + x] = v;                                                           \n"
+  "      res = fabs(tile[c] - v);                                                          \n"
+  "   }                                                                                    \n"
+  "   barrier(CLK_LOCAL_MEM_FENCE);                                                        \n"
+  "   tile[wg_i] = res;                                                                    \n"
+  "   barrier(CLK_LOCAL_MEM_FENCE);                                                        \n"
+  "                                                                                        \n"
+  "   for(int offset = 1; offset < wg_size; offset *= 2)                                   \n"
+  "   {                                                                                    \n"
+  "      int mask = 2*offset - 1;                                                          \n"
+  "      if ((wg_i & mask) == 0 && wg_i + offset < wg_size)                                \n"
+  "      {                                                                                 \n"
+  "         tile[wg_i] = fmax(tile[wg_i], tile[wg_i + offset]);                            \n"
+  "      }                                                                                 \n"
+  "      barrier(CLK_LOCAL_MEM_FENCE);                                                     \n"
+  "   }                                                                                    \n"
+  "                                                                                        \n"
+  "   if(wg_i == 0 && tile[0] > eps) {                                                     \n"
+  "      atomic_inc(&record[0]);                                                           \n"
+  "      atomic_max(&record[1], as_int((float)tile[0]));                                   \n"
+  "   }                                                                                    \n"
+  "}                                                                                       \n"
+  "\n";
+
+int main()
+{
+   cl_int err;
+   kernel_struct kernels;
+   cl_kernel kernel;
+   size_t global[2];
+   size_t local[2];
+  
+   double *a,*b;
+   static int record[2];            // (unstable groups, residual) of a sweep
+   static int zeros[2];
+   int nx, ny, pitch, count;
+   int iterations = 0;
+
+   nx = NX;
+   ny = NY;
+   pitch = rowPitch(nx);
+
+   a = allocPlate(pitch, ny);
+   b = allocPlate(pitch, ny);
+
+   init(a, nx, ny, pitch);
+   init(b, nx, ny, pitch);
+
+   count = 0;
+   
+   local[0] = TILE_X;
+   local[1] = TILE_Y;
+   printf("work group size: %d x %d\n", (int)local[0], (int)local[1]);
+   global[0] = ((nx + local[0] - 1) / local[0]) * local[0];
+   global[1] = ((ny + local[1] - 1) / local[1]) * local[1];
+   printf("global work size: %d x %d\n\n", (int)global[0], (int)global[1]);
+
+   printf("size   : %d x %d, row pitch %d (%d MB)\n", nx, ny, pitch,
+          (int)((size_t)pitch*ny*sizeof(double) / (1024*1024)));
+   printf("heat   : %f\n", HEAT);
+   printf("epsilon: %f\n", EPS);
+   
+   err = initGPU();
+   //clPrintDevInfo();
+      
+   if (err == CL_SUCCESS) {
+      clock_gettime(1, &start);
+      kernels = setupKernel(KernelSource, "relax", (TILE_X + 2) * (TILE_Y + 2), 7, DoubleArr, pitch*ny, a, DoubleArr, pitch*ny, b, IntArr, 2, record, DoubleConst, EPS, IntConst, nx, IntConst, ny, IntConst, pitch);
+      // only the record is needed on the host while iterating
+      setTransferPolicy(1, TransferAtEnd, 0);
+      setTransferPolicy(2, TransferAtEnd, 0);
+
+      do {
+         if(count == 0) {
+            kernel = kernels.kernel1;
+            count++;
+         } else {
+            kernel = kernels.kernel2;
+            count--;
+         }
+         host2devIntArr(zeros, argBuffer(3), 2);
+         runKernelSelective(kernel, 2, global, local);
+
+         iterations++;
+      } while(!isStable(record));
+      fetchFinal();
+      
+      clock_gettime(1, &stop);
+      
+      printf("Number of iterations: %d\n", iterations);
+      printTimeElapsed("GPU time spent");
+      printKernelTime();
+      
+      err = clReleaseKernel(kernels.kernel1);
+      err = clReleaseKernel(kernels.kernel2);
+      err = freeDevice();
+   }
+
+   return 0;
+}
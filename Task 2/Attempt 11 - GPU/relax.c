@@ -0,0 +1,284 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <limits.h>
+#include <math.h>
+#include <CL/cl.h>
+#include <time.h>
+
+#include "simple.h"
+
+#define NX 256       // default extents of the volume, see usage()
+#define NY 256
+#define NZ 256
+#define EPS 0.1      // convergence criterium
+#define HEAT 100.0   // heat value on the bottom face (z = 0)
+
+#define TILE_X 32    // work group width
+#define TILE_Y 8     // work group height
+#define ZCHUNK 64    // planes streamed by one work group
+#define PITCH 32     // rows start at multiples of PITCH doubles (256 bytes)
+
+struct timespec start, stop;
+
+void printTimeElapsed(char *text)
+{
+  double elapsed = (stop.tv_sec -start.tv_sec)*1000.0
+                  + (double)(stop.tv_nsec -start.tv_nsec)/1000000.0;
+  printf( "%s: %f msec\n", text, elapsed);
+}
+
+void usage(char *name)
+{
+   printf("usage: %s [nx ny nz]   (default %d %d %d)\n", name, NX, NY, NZ);
+}
+
+//
+// row pitch in doubles for a volume of width "nx": rows are padded to a
+// multiple of PITCH so that every row starts on an aligned address
+//
+int rowPitch(int nx)
+{
+   return ((nx + PITCH - 1) / PITCH) * PITCH;
+}
+
+//
+// allocate a volume of "n" doubles (rows already padded)
+//
+double *allocVolume(size_t n)
+{
+   double *v;
+   v = (double *)malloc( n*sizeof(double));
+   return v;
+}
+
+//
+// initialise the volume "out" of "nx" x "ny" x "nz" cells with row pitch
+// "pitch": the bottom face (z = 0) is held at HEAT, everything else
+// (including the row padding) is 0
+//
+void init(double *out, int nx, int ny, int nz, int pitch)
+{
+   size_t plane = (size_t)pitch * ny;
+   size_t i;
+   int x, y;
+
+   for(i=0; i<plane*nz; i++) {
+      out[i] = 0;
+   }
+   for(y=0; y<ny; y++) {
+      for(x=0; x<nx; x++) {
+         out[(size_t)y*pitch + x] = HEAT;
+      }
+   }
+}
+
+//
+// checks the convergence criterion for the last sweep: true, iff no work
+// group found a cell with |out - in| > eps
+//
+bool isStable(int *record)
+{
+   return record[0] == 0;
+}
+
+//
+//relax function in kernel source: one seven-point Jacobi sweep over a 3D
+//volume with 2.5D blocking. The work groups tile the x-y plane and each
+//streams through ZCHUNK planes in z. A work item keeps the column below,
+//at and above its current plane in registers. Only the current plane goes
+//through local memory, where the items on the edges of the group add the
+//x-y halo, so every cell of "in" is read from global memory about once.
+//
+const char *KernelSource =                                                                 "\n"
+  "__kernel void relax(                                                                    \n"
+  "   __local  double* tile,                                                               \n"
+  "   __global double* in,                                                                 \n"
+  "   __global double* out,                                                                \n"
+  "   __global int* record,                                                                \n"
+  "   const double eps,                                                                    \n"
+  "   const unsigned int nx,                                                               \n"
+  "   const unsigned int ny,                                                               \n"
+  "   const unsigned int nz,                                                               \n"
+  "   const unsigned int pitch,                                                            \n"
+  "   const unsigned int zchunk)                                                           \n"
+  "{                                                                                       \n"
+  "   int x = get_global_id(0);                                                            \n"
+  "   int y = get_global_id(1);                                                            \n"
+  "   int wx = get_local_size(0);                                                          \n"
+  "   int wy = get_local_size(1);                                                          \n"
+  "   int lx = get_local_id(0);                                                            \n"
+  "   int ly = get_local_id(1);                                                            \n"
+  "   int wg_size = wx * wy;                                                               \n"
+  "   int wg_i = ly * wx + lx;                                                             \n"
+  "   int tw = wx + 2;                                                                     \n"
+  "   int c = (ly + 1) * tw + lx + 1;                                                      \n"
+  "   int z0 = get_global_id(2) * zchunk;                                                  \n"
+  "   int z1 = min(z0 + (int)zchunk, (int)nz);                                             \n"
+  "   bool inside = x < nx && y < ny;                                                      \n"
+  "   bool inner = x > 0 && x < nx-1 && y > 0 && y < ny-1;                                 \n"
+  "   size_t plane = (size_t)pitch * ny;                                                   \n"
+  "   size_t i = (size_t)z0 * plane + (size_t)y * pitch + x;                               \n"
+  "   double below = 0.0;                                                                  \n"
+  "   double cur = 0.0;                                                                    \n"
+  "   double above = 0.0;                                                                  \n"
+  "   double res = 0.0;                                                                    \n"
+  "   double v;                                                                            \n"
+  "                                                                                        \n"
+  "   if (inside && z0 > 0)                                                                \n"
+  "      below = in[i - plane];                                                            \n"
+  "   if (inside && z0 < nz)                                                               \n"
+  "      cur = in[i];                                                                      \n"
+  "                                                                                        \n"
+  "   for (int z = z0; z < z1; z++, i += plane) {                                          \n"
+  "      above = (inside && z+1 < nz) ? in[i + plane] : 0.0;                               \n"
+  "                                                                                        \n"
+  "      barrier(CLK_LOCAL_MEM_FENCE);                                                     \n"
+  "      tile[c] = cur;                                                                    \n"
+  "      if (lx == 0)                                                                      \n"
+  "         tile[c-1] = (x > 0 && y < ny) ? in[i-1] : 0.0;                                 \n"
+  "      if (lx == wx-1)                                                                   \n"
+  "         tile[c+1] = (x+1 < nx && y < ny) ? in[i+1] : 0.0;                              \n"
+  "      if (ly == 0)                                                                      \n"
+  "         tile[c-tw] = (y > 0 && x < nx) ? in[i-pitch] : 0.0;                            \n"
+  "      if (ly == wy-1)                                                                   \n"
+  "         tile[c+tw] = (y+1 < ny && x < nx) ? in[i+pitch] : 0.0;                         \n"
+  "      barrier(CLK_LOCAL_MEM_FENCE);                                                     \n"
+  "                                                                                        \n"
+  "      if (inside) {                                                                     \n"
+  "         if (inner && z > 0 && z < nz-1) {                                              \n"
+  "            v = 0.5*cur + (tile[c-1] + tile[c+1] + tile[c-tw] + tile[c+tw]              \n"
+  "                           + below + above) / 12.0;                                     \n"
+  "         } else {                                                                       \n"
+  "            v = cur;                                                                    \n"
+  "         }                                                                              \n"
+  "         out[i] = v;                                                                    \n"
+  "         res = fmax(res, fabs(cur - v));                                                \n"
+  "      }                                                                                 \n"
+  "      below = cur;                                                                      \n"
+  "      cur = above;                                                                      \n"
+  "   }                                                                                    \n"
+  "                                                                                        \n"
+  "   barrier(CLK_LOCAL_MEM_FENCE);                                                        \n"
+  "   tile[wg_i] = res;                                                                    \n"
+  "   barrier(CLK_LOCAL_MEM_FENCE);                                                        \n"
+  "                                                                                        \n"
+  "   for(int offset = 1; offset < wg_size; offset *= 2)                                   \n"
+  "   {                                                                                    \n"
+  "      int mask = 2*offset - 1;                                                          \n"
+  "      if ((wg_i & mask) == 0 && wg_i + offset < wg_size)                                \n"
+  "      {                                                                                 \n"
+  "         tile[wg_i] = fmax(tile[wg_i], tile[wg_i + offset]);                            \n"
+  "      }                                                                                 \n"
+  "      barrier(CLK_LOCAL_MEM_FENCE);                                                     \n"
+  "   }                                                                                    \n"
+  "                                                                                        \n"
+  "   if(wg_i == 0 && tile[0] > eps) {                                                     \n"
+  "      atomic_inc(&record[0]);                                                           \n"
+  "      atomic_max(&record[1], as_int((float)tile[0]));                                   \n"
+  "   }                                                                                    \n"
+  "}                                                                                       \n"
+  "\n";
+
+int main(int argc, char **argv)
+{
+   cl_int err;
+   kernel_struct kernels;
+   cl_kernel kernel;
+   size_t global[3];
+   size_t local[3];
+  
+   double *a;
+   static int record[2];            // (unstable groups, residual) of a sweep
+   static int zeros[2];
+   size_t n;
+   int nx, ny, nz, pitch, count;
+   int iterations = 0;
+
+   nx = NX;
+   ny = NY;
+   nz = NZ;
+   if (argc == 4) {
+      nx = atoi(argv[1]);
+      ny = atoi(argv[2]);
+      nz = atoi(argv[3]);
+   } else if (argc != 1) {
+      usage(argv[0]);
+      return 1;
+   }
+   if (nx < 1 || ny < 1 || nz < 1) {
+      usage(argv[0]);
+      return 1;
+   }
+   pitch = rowPitch(nx);
+   n = (size_t)pitch * ny * nz;
+   if (n > INT_MAX) {
+      printf("volume of %zu cells is too large\n", n);
+      return 1;
+   }
+
+   // both device buffers start from the same volume, so one host copy is
+   // enough: it receives the result at the end
+   a = allocVolume(n);
+   if (a == NULL) {
+      printf("cannot allocate %zu MB\n", n*sizeof(double) / (1024*1024));
+      return 1;
+   }
+
+   init(a, nx, ny, nz, pitch);
+
+   count = 0;
+   
+   local[0] = TILE_X;
+   local[1] = TILE_Y;
+   local[2] = 1;
+   printf("work group size: %d x %d, %d planes\n", (int)local[0], (int)local[1], ZCHUNK);
+   global[0] = ((nx + local[0] - 1) / local[0]) * local[0];
+   global[1] = ((ny + local[1] - 1) / local[1]) * local[1];
+   global[2] = (nz + ZCHUNK - 1) / ZCHUNK;
+   printf("global work size: %d x %d x %d\n\n", (int)global[0], (int)global[1], (int)global[2]);
+
+   printf("size   : %d x %d x %d, row pitch %d (%d MB)\n", nx, ny, nz, pitch,
+          (int)(n*sizeof(double) / (1024*1024)));
+   printf("heat   : %f\n", HEAT);
+   printf("epsilon: %f\n", EPS);
+   
+   err = initGPU();
+   //clPrintDevInfo();
+      
+   if (err == CL_SUCCESS) {
+      clock_gettime(1, &start);
+      kernels = setupKernel(KernelSource, "relax", (TILE_X + 2) * (TILE_Y + 2), 9, DoubleArr, (int)n, a, DoubleArr, (int)n, a, IntArr, 2, record, DoubleConst, EPS, IntConst, nx, IntConst, ny, IntConst, nz, IntConst, pitch, IntConst, ZCHUNK);
+      // only the record is needed on the host while iterating
+      setTransferPolicy(1, TransferNever, 0);
+      setTransferPolicy(2, TransferNever, 0);
+
+      do {
+         if(count == 0) {
+            kernel = kernels.kernel1;
+            count++;
+         } else {
+            kernel = kernels.kernel2;
+            count--;
+         }
+         host2devIntArr(zeros, argBuffer(3), 2);
+         runKernelSelective(kernel, 3, global, local);
+
+         iterations++;
+      } while(!isStable(record));
+      // the last sweep wrote b after kernel1, a after kernel2
+      fetchArg((count == 1) ? 2 : 1);
+      
+      clock_gettime(1, &stop);
+      
+      printf("Number of iterations: %d\n", iterations);
+      printTimeElapsed("GPU time spent");
+      printKernelTime();
+      
+      err = clReleaseKernel(kernels.kernel1);
+      err = clReleaseKernel(kernels.kernel2);
+      err = freeDevice();
+   }
+
+   return 0;
+}
@@ -0,0 +1,274 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <CL/cl.h>
+#include "simple.h"
+#include "checkpoint.h"
+
+#define CKPT_MAGIC "HEATCKPT"
+#define CKPT_VERSION 1
+
+#define die(msg, ...) do {                      \
+  (void) fprintf (stderr, msg, ## __VA_ARGS__); \
+  (void) fprintf (stderr, "\n");                \
+} while (0)
+
+typedef struct {
+  char     magic[8];
+  int32_t  version;
+  int32_t  n;
+  double   eps;
+  double   heat;
+  int64_t  iteration;
+  uint64_t checksum;
+  int32_t  valid;             /* Written last, after the vector is synced.  */
+} ckpt_header;
+
+struct checkpoint {
+  int     fd;
+  int     n;
+  double  eps;
+  double  heat;
+  size_t  page;
+  size_t  slot_bytes;         /* Header page plus the vector, page aligned.  */
+  char   *map;                /* Shared mapping of both slots.  */
+  void   *resume_map;         /* Private mapping of the resumed slot.  */
+  int     latest;             /* Slot of the latest checkpoint, -1 if none.  */
+  int     slot;               /* Slot of the last beginCheckpoint.  */
+
+  /* writer thread */
+  pthread_t       writer;
+  pthread_mutex_t lock;
+  pthread_cond_t  cond;
+  bool            busy;       /* A checkpoint is being written.  */
+  bool            pending;    /* ... and has not been taken by the writer.  */
+  bool            stop;
+  cl_event        ev;
+  int             iteration;
+};
+
+static ckpt_header *slotHeader( checkpoint *c, int s)
+{
+  return (ckpt_header *) (c->map + s * c->slot_bytes);
+}
+
+static double *slotData( checkpoint *c, int s)
+{
+  return (double *) (c->map + s * c->slot_bytes + c->page);
+}
+
+/* FNV-1a over the 64-bit words of the vector.  */
+static uint64_t checksum( const double *v, int n)
+{
+  uint64_t h = 14695981039346656037ULL;
+  uint64_t w;
+
+  for (int i = 0; i < n; i++) {
+    memcpy (&w, &v[i], sizeof (w));
+    h = (h ^ w) * 1099511628211ULL;
+  }
+  return h;
+}
+
+/* True iff slot "s" holds a complete checkpoint of this problem.  */
+static bool slotMatches( checkpoint *c, int s)
+{
+  ckpt_header *h = slotHeader (c, s);
+
+  return (memcmp (h->magic, CKPT_MAGIC, sizeof (h->magic)) == 0)
+         && (h->version == CKPT_VERSION) && (h->valid == 1)
+         && (h->n == c->n) && (h->eps == c->eps) && (h->heat == c->heat);
+}
+
+static void *writerThread( void *p)
+{
+  checkpoint *c = (checkpoint *) p;
+  ckpt_header *h;
+  cl_event ev;
+  int iteration, s;
+
+  pthread_mutex_lock (&c->lock);
+  for (;;) {
+    while (!c->pending && !c->stop)
+      pthread_cond_wait (&c->cond, &c->lock);
+    if (!c->pending)
+      break;
+    c->pending = false;
+    ev = c->ev;
+    iteration = c->iteration;
+    s = c->slot;
+    pthread_mutex_unlock (&c->lock);
+
+    /* The vector has to be on disk before the header declares it valid.  */
+    if ((ev != NULL) && (waitEvent (ev) == CL_SUCCESS)) {
+      h = slotHeader (c, s);
+      memcpy (h->magic, CKPT_MAGIC, sizeof (h->magic));
+      h->version = CKPT_VERSION;
+      h->n = c->n;
+      h->eps = c->eps;
+      h->heat = c->heat;
+      h->iteration = iteration;
+      h->checksum = checksum (slotData (c, s), c->n);
+      msync (slotData (c, s), c->slot_bytes - c->page, MS_SYNC);
+      h->valid = 1;
+      msync (h, c->page, MS_SYNC);
+    }
+
+    pthread_mutex_lock (&c->lock);
+    if ((ev != NULL) && (slotHeader (c, s)->valid == 1))
+      c->latest = s;
+    c->busy = false;
+  }
+  pthread_mutex_unlock (&c->lock);
+
+  return NULL;
+}
+
+/* public interface */
+
+checkpoint *openCheckpoint( const char *path, int n, double eps, double heat)
+{
+  checkpoint *c;
+  struct stat st;
+  size_t bytes;
+
+  c = (checkpoint *) calloc (1, sizeof (checkpoint));
+  if (c == NULL)
+    return NULL;
+  c->n = n;
+  c->eps = eps;
+  c->heat = heat;
+  c->page = sysconf (_SC_PAGESIZE);
+  c->slot_bytes = c->page
+                  + ((sizeof (double) * n + c->page - 1) / c->page) * c->page;
+  c->latest = -1;
+  c->slot = -1;
+  bytes = 2 * c->slot_bytes;
+
+  c->fd = open (path, O_RDWR | O_CREAT, 0644);
+  if (c->fd < 0) {
+    die ("Error: Failed to open checkpoint file %s!", path);
+    free (c);
+    return NULL;
+  }
+  /* A file of another size cannot hold a checkpoint of this problem.  */
+  if ((fstat (c->fd, &st) != 0) || ((size_t) st.st_size != bytes)) {
+    if (ftruncate (c->fd, bytes) != 0) {
+      die ("Error: Failed to resize checkpoint file %s!", path);
+      close (c->fd);
+      free (c);
+      return NULL;
+    }
+  }
+  c->map = (char *) mmap (NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED,
+                          c->fd, 0);
+  if (c->map == MAP_FAILED) {
+    die ("Error: Failed to map checkpoint file %s!", path);
+    close (c->fd);
+    free (c);
+    return NULL;
+  }
+
+  for (int s = 0; s < 2; s++) {
+    if (slotMatches (c, s)
+         && ((c->latest < 0)
+             || (slotHeader (c, s)->iteration > slotHeader (c, c->latest)->iteration)))
+      c->latest = s;
+  }
+
+  pthread_mutex_init (&c->lock, NULL);
+  pthread_cond_init (&c->cond, NULL);
+  if (pthread_create (&c->writer, NULL, writerThread, c) != 0) {
+    die ("Error: Failed to create the checkpoint writer!");
+    munmap (c->map, bytes);
+    close (c->fd);
+    free (c);
+    return NULL;
+  }
+
+  return c;
+}
+
+double *resumeCheckpoint( checkpoint *c, int *iteration)
+{
+  int order[2];
+  int s;
+
+  /* Newest first; fall back to the older slot if its checksum is wrong.  */
+  order[0] = (c->latest < 0) ? 0 : c->latest;
+  order[1] = 1 - order[0];
+  for (int i = 0; i < 2; i++) {
+    s = order[i];
+    if (!slotMatches (c, s)
+         || (checksum (slotData (c, s), c->n) != slotHeader (c, s)->checksum))
+      continue;
+
+    c->resume_map = mmap (NULL, c->slot_bytes, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE, c->fd, s * c->slot_bytes);
+    if (c->resume_map == MAP_FAILED) {
+      die ("Error: Failed to map checkpoint slot %d!", s);
+      c->resume_map = NULL;
+      return NULL;
+    }
+    /* Keep this slot; the next checkpoint overwrites the other one.  */
+    c->latest = s;
+    *iteration = (int) slotHeader (c, s)->iteration;
+    return (double *) ((char *) c->resume_map + c->page);
+  }
+  return NULL;
+}
+
+double *beginCheckpoint( checkpoint *c)
+{
+  ckpt_header *h;
+
+  pthread_mutex_lock (&c->lock);
+  if (c->busy) {
+    pthread_mutex_unlock (&c->lock);
+    return NULL;
+  }
+  c->slot = (c->latest == 0) ? 1 : 0;
+  pthread_mutex_unlock (&c->lock);
+
+  h = slotHeader (c, c->slot);
+  h->valid = 0;
+  msync (h, c->page, MS_ASYNC);
+
+  return slotData (c, c->slot);
+}
+
+void commitCheckpoint( checkpoint *c, cl_event ev, int iteration)
+{
+  pthread_mutex_lock (&c->lock);
+  c->ev = ev;
+  c->iteration = iteration;
+  c->busy = true;
+  c->pending = true;
+  pthread_cond_signal (&c->cond);
+  pthread_mutex_unlock (&c->lock);
+}
+
+void closeCheckpoint( checkpoint *c)
+{
+  pthread_mutex_lock (&c->lock);
+  c->stop = true;
+  pthread_cond_signal (&c->cond);
+  pthread_mutex_unlock (&c->lock);
+  pthread_join (c->writer, NULL);
+
+  if (c->resume_map != NULL)
+    munmap (c->resume_map, c->slot_bytes);
+  munmap (c->map, 2 * c->slot_bytes);
+  close (c->fd);
+  pthread_mutex_destroy (&c->lock);
+  pthread_cond_destroy (&c->cond);
+  free (c);
+}
@@ -0,0 +1,63 @@
+#ifndef CHECKPOINT_H_
+#define CHECKPOINT_H_
+
+#include <CL/cl.h>
+
+typedef struct checkpoint checkpoint;
+
+/*******************************************************************************
+ *
+ * openCheckpoint : opens (or creates) the checkpoint file "path" for a
+ *                  vector of length "n" relaxed with "eps" and "heat", and
+ *                  maps it shared into memory. The file has two slots, each
+ *                  a header page (n, eps, heat, iteration, checksum) followed
+ *                  by the vector; checkpoints alternate between the slots,
+ *                  so a crash while one is written leaves the other intact.
+ *                  A writer thread finishes the checkpoints in the
+ *                  background. Returns NULL if the file cannot be mapped.
+ *
+ ******************************************************************************/
+extern checkpoint *openCheckpoint( const char *path, int n, double eps,
+                                   double heat);
+
+/*******************************************************************************
+ *
+ * resumeCheckpoint : returns the vector of the latest complete checkpoint
+ *                    whose header matches n, eps and heat and whose
+ *                    checksum is right, and sets "*iteration" to its
+ *                    iteration. The vector is a private mapping of the file:
+ *                    it can be handed to setupKernel directly, and writing
+ *                    to it does not change the file. It stays valid until
+ *                    closeCheckpoint. Returns NULL if there is no such
+ *                    checkpoint. Must be called before the first
+ *                    beginCheckpoint.
+ *
+ ******************************************************************************/
+extern double *resumeCheckpoint( checkpoint *c, int *iteration);
+
+/*******************************************************************************
+ *
+ * beginCheckpoint : invalidates the older slot and returns its vector, into
+ *                   which the caller transfers the snapshot (for example with
+ *                   snapshotDoubleArr). Returns NULL without blocking while
+ *                   the writer thread still finishes the previous
+ *                   checkpoint.
+ *
+ * commitCheckpoint : hands the slot of the last beginCheckpoint to the
+ *                    writer thread: once the transfer of event "ev" has
+ *                    completed, it computes the checksum, flushes the
+ *                    vector to the file and then writes the header for
+ *                    "iteration", which makes the slot valid.
+ *
+ ******************************************************************************/
+extern double *beginCheckpoint( checkpoint *c);
+extern void commitCheckpoint( checkpoint *c, cl_event ev, int iteration);
+
+/*******************************************************************************
+ *
+ * closeCheckpoint : waits for the writer thread and unmaps the file.
+ *
+ ******************************************************************************/
+extern void closeCheckpoint( checkpoint *c);
+
+#endif /* CHECKPOINT_H_ */
@@ -0,0 +1,231 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <math.h>
+#include <string.h>
+#include <CL/cl.h>
+#include <time.h>
+
+#include "simple.h"
+#include "checkpoint.h"
+
+#define N 10000000   // length of the vectors
+#define EPS 0.1      // convergence criterium
+#define HEAT 100.0   // heat value on the boundary
+
+#define CKPT_FILE "relax.ckpt"   // checkpoint file, see checkpoint.h
+#define CKPT_EVERY 50            // sweeps between checkpoints
+
+struct timespec start, stop;
+
+void printTimeElapsed(char *text)
+{
+  double elapsed = (stop.tv_sec -start.tv_sec)*1000.0
+                  + (double)(stop.tv_nsec -start.tv_nsec)/1000000.0;
+  printf( "%s: %f msec\n", text, elapsed);
+}
+
+void usage(char *name)
+{
+   printf("usage: %s [--resume]\n", name);
+}
+
+//
+// allocate a double vector of length "n"
+//
+double *allocVector(int n)
+{
+   double *v;
+   v = (double *)malloc( n*sizeof(double));
+   return v;
+}
+
+//
+// initialise the values of the given vector "out" of length "n"
+//
+void init(double *out, int n)
+{
+   int i;
+
+   for(i=1; i<n; i++) {
+      out[i] = 0;
+   }
+   out[0] = HEAT;
+}
+
+//
+// print the values of a given vector "out" of length "n"
+//
+void print(double *out, int n)
+{
+   int i;
+
+   printf("<");
+   for( i=0; i<n; i++) {
+      printf(" %f", out[i]);
+   }
+   printf(">\n");
+}
+
+//
+// checks the convergence criterion for the last sweep: true, iff no work
+// group found an index i with |out[i] - in[i]| > eps
+//
+bool isStable(int *record)
+{
+   return record[0] == 0;
+}
+
+//
+//relax function in kernel source, as in Attempt 2; only slot 0 is used
+//
+const char *KernelSource =                                                     "\n"
+  "__kernel void relax(                                                         \n"
+  "   __local  double* res_l,                                                   \n"
+  "   __global double* in,                                                      \n"
+  "   __global double* out,                                                     \n"
+  "   __global int* record,                                                     \n"
+  "   const double eps,                                                         \n"
+  "   const unsigned int count,                                                 \n"
+  "   const unsigned int slot)                                                  \n"
+  "{                                                                            \n"
+  "   int i = get_global_id(0);                                                 \n"
+  "   int n = get_global_size(0);                                               \n"
+  "   int wg_size = get_local_size(0);                                          \n"
+  "   int wg_i = get_local_id(0);                                               \n"
+  "                                                                             \n"
+  "   if (i > 0 && i < n-1) {                                                   \n"
+  "      out[i] = 0.25*in[i-1] + 0.5*in[i] + 0.25*in[i+1];                      \n"
+  "   } else {                                                                  \n"
+  "      out[i] = in[i];                                                        \n"
+  "   }                                                                         \n"
+  "   res_l[wg_i] = fabs(in[i] - out[i]);                                       \n"
+  "   barrier(CLK_LOCAL_MEM_FENCE);                                             \n"
+  "                                                                             \n"
+  "   for(int offset = 1; offset < wg_size; offset *= 2)                        \n"
+  "   {                                                                         \n"
+  "      int mask = 2*offset - 1;                                               \n"
+  "      if ((wg_i & mask) == 0 && wg_i + offset < wg_size)                     \n"
+  "      {                                                                      \n"
+  "         res_l[wg_i] = fmax(res_l[wg_i], res_l[wg_i + offset]);              \n"
+  "      }                                                                      \n"
+  "      barrier(CLK_LOCAL_MEM_FENCE);                                          \n"
+  "   }                                                                         \n"
+  "                                                                             \n"
+  "   if(wg_i == 0 && res_l[0] > eps) {                                         \n"
+  "      atomic_inc(&record[2*slot]);                                           \n"
+  "      atomic_max(&record[2*slot + 1], as_int((float)res_l[0]));              \n"
+  "   }                                                                         \n"
+  "}                                                                            \n"
+  "\n";
+
+int main(int argc, char **argv)
+{
+   cl_int err;
+   kernel_struct kernels;
+   cl_kernel kernel;
+   size_t global[1];
+   size_t local[1];
+  
+   double *a = NULL;
+   double *dst;
+   checkpoint *ckpt;
+   cl_mem snapshot;
+   static int record[2];            // (unstable groups, residual) of a sweep
+   static int zeros[2];
+   bool resume = false;
+   int n, count;
+   int iterations = 0;
+   int checkpoints = 0;
+
+   if (argc == 2 && strcmp(argv[1], "--resume") == 0) {
+      resume = true;
+   } else if (argc != 1) {
+      usage(argv[0]);
+      return 1;
+   }
+
+   n = N;
+
+   // the resumed vector is mapped from the file and uploaded from there;
+   // both device buffers start from it, so one host vector is enough
+   ckpt = openCheckpoint(CKPT_FILE, n, EPS, HEAT);
+   if (resume && ckpt != NULL)
+      a = resumeCheckpoint(ckpt, &iterations);
+   if (resume && a == NULL)
+      printf("no checkpoint to resume in %s, starting from scratch\n", CKPT_FILE);
+   if (a == NULL) {
+      a = allocVector(n);
+      init(a, n);
+      iterations = 0;
+   } else {
+      printf("resuming from sweep %d\n", iterations);
+   }
+   // the parity of the sweep selects the kernel, as without the restart
+   count = iterations % 2;
+   
+   local[0] = 32;
+   printf("work group size: %d\n", (int)local[0]);
+   global[0] = n;
+   printf("global work size: %d\n\n", n);
+
+   printf("size   : %d M (%d MB)\n", n/1000000, (int)(n*sizeof(double) / (1024*1024)));
+   printf("heat   : %f\n", HEAT);
+   printf("epsilon: %f\n", EPS);
+   if (ckpt != NULL)
+      printf("checkpoint: every %d sweeps to %s\n", CKPT_EVERY, CKPT_FILE);
+   
+   err = initGPU();
+   //clPrintDevInfo();
+      
+   if (err == CL_SUCCESS) {
+      clock_gettime(1, &start);
+      kernels = setupKernel(KernelSource, "relax", local[0], 6, DoubleArr, n, a, DoubleArr, n, a, IntArr, 2, record, DoubleConst, EPS, IntConst, n, IntConst, 0);
+      // only the record is needed on the host while iterating
+      setTransferPolicy(1, TransferNever, 0);
+      setTransferPolicy(2, TransferNever, 0);
+      snapshot = allocDev(sizeof(double) * n);
+
+      do {
+         if(count == 0) {
+            kernel = kernels.kernel1;
+            count++;
+         } else {
+            kernel = kernels.kernel2;
+            count--;
+         }
+         host2devIntArrAsync(zeros, argBuffer(3), 0, 2);
+         runKernelSelective(kernel, 1, global, local);
+         iterations++;
+
+         // the sweep wrote b after kernel1, a after kernel2; a checkpoint
+         // still being written makes this one skip instead of waiting
+         if (ckpt != NULL && iterations % CKPT_EVERY == 0 && !isStable(record)) {
+            dst = beginCheckpoint(ckpt);
+            if (dst != NULL) {
+               commitCheckpoint(ckpt, snapshotDoubleArr(argBuffer((count == 1) ? 2 : 1), snapshot, dst, n), iterations);
+               checkpoints++;
+            }
+         }
+      } while(!isStable(record));
+      fetchArg((count == 1) ? 2 : 1);
+      
+      clock_gettime(1, &stop);
+      
+      printf("Number of iterations: %d\n", iterations);
+      printf("Number of checkpoints: %d\n", checkpoints);
+      printTimeElapsed("GPU time spent");
+      printKernelTime();
+      
+      if (ckpt != NULL)
+         closeCheckpoint(ckpt);
+      releaseDev(snapshot);
+      err = clReleaseKernel(kernels.kernel1);
+      err = clReleaseKernel(kernels.kernel2);
+      err = freeDevice();
+   } else if (ckpt != NULL) {
+      closeCheckpoint(ckpt);
+   }
+
+   return 0;
+}
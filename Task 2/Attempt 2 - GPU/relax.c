@@ -2,6 +2,7 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include <math.h>
+#include <string.h>
 #include <CL/cl.h>
 #include <time.h>
 
@@ -11,6 +12,14 @@
 #define EPS 0.1      // convergence criterium
 #define HEAT 100.0   // heat value on the boundary
 
+#define CHECK_INTERVAL 0   // sweeps between convergence checks, 0 = adaptive
+#define KMAX 64            // upper bound for the adaptive check interval
+#define SPECULATE 1        // enqueue the next batch before checking the last
+
+#if CHECK_INTERVAL > KMAX
+#error "CHECK_INTERVAL must not exceed KMAX"
+#endif
+
 struct timespec start, stop;
 
 void printTimeElapsed(char *text)
@@ -30,16 +39,6 @@ double *allocVector(int n)
    return v;
 }
 
-//
-// allocate a bool vector of length "n"
-//
-bool *allocStable(int n)
-{
-   bool *s;
-   s = (bool *)malloc( n*sizeof(bool));
-   return s;
-}
-
 //
 // initialise the values of the given vector "out" of length "n"
 //
@@ -55,45 +54,74 @@ void init(double *out, int n)
 }
 
 //
-// initialise the values of the given vector "out" of length "n"
+// print the values of a given vector "out" of length "n"
 //
-void binit(bool *out, int n)
+void print(double *out, int n)
 {
    int i;
 
-   for(i=1; i<n; i++) {
-      out[i] = false;
+   printf("<");
+   for( i=0; i<n; i++) {
+      printf(" %f", out[i]);
    }
+   printf(">\n");
+}
 
+//
+// checks the convergence criterion for the sweep recorded in slot "slot":
+// true, iff no work group found an index i with |out[i] - in[i]| > eps.
+// The record holds two halves of KMAX slots, one per batch in flight; the
+// host clears a half before the batch that uses it.
+//
+bool isStable(int *record, int slot)
+{
+   return record[2*slot] == 0;
 }
 
 //
-// print the values of a given vector "out" of length "n"
+// returns the largest |out[i] - in[i]| > eps of the sweep in slot "slot"
+// (0 if stable), stored by the kernel as the bits of a float
 //
-void print(double *out, int n)
+double residual(int *record, int slot)
 {
-   int i;
+   float r;
 
-   printf("<");
-   for( i=0; i<n; i++) {
-      printf(" %f", out[i]);
-   }
-   printf(">\n");
+   memcpy(&r, &record[2*slot + 1], sizeof(float));
+   return r;
 }
 
 //
-// checks the convergence criterion:
-// true, iff for all indices i, we have |out[i] - in[i]| <= eps
+// picks the number of sweeps for the next batch from the residual decay
+// rate within the "k" sweeps recorded from slot "slot" on: it extrapolates
+// how many sweeps are left until the residual drops below eps, and otherwise
+// doubles
 //
-bool isStable(bool *stable, int n)
+int nextInterval(int *record, int slot, int k)
 {
-   int i;
-   
-   for(i=0; i<n-1; i++) {
-      if (!stable[i])
-         return false;
+   double r0 = residual(record, slot);
+   double r1 = residual(record, slot + k - 1);
+   double rate, left;
+   int next = (2*k < KMAX) ? 2*k : KMAX;
+
+   if (k > 1 && r1 > 0.0 && r1 < r0) {
+      rate = log(r1 / r0) / (k - 1);
+      left = ceil(log(EPS / r1) / rate);
+      if (left < next)
+         next = (left < 1.0) ? 1 : (int)left;
    }
-   return true;
+   return next;
+}
+
+//
+// enqueues sweep "s" recording into slot "slot", alternating the two
+// ping-pong kernels
+//
+void sweep(kernel_struct kernels, int s, int slot, size_t *global, size_t *local)
+{
+   cl_kernel kernel = (s % 2 == 0) ? kernels.kernel1 : kernels.kernel2;
+
+   setKernelIntArg(kernel, 6, slot);
+   enqueueKernel(kernel, 1, global, local);
 }
 
 //
@@ -101,36 +129,41 @@ bool isStable(bool *stable, int n)
 //
 const char *KernelSource =                                                     "\n"
   "__kernel void relax(                                                         \n"
-  "   __local  bool* stable_l,                                                  \n"
+  "   __local  double* res_l,                                                   \n"
   "   __global double* in,                                                      \n"
   "   __global double* out,                                                     \n"
-  "   __global bool* stable,                                                    \n"
+  "   __global int* record,                                                     \n"
   "   const double eps,                                                         \n"
-  "   const unsigned int count)                                                 \n"
+  "   const unsigned int count,                                                 \n"
+  "   const unsigned int slot)                                                  \n"
   "{                                                                            \n"
   "   int i = get_global_id(0);                                                 \n"
   "   int n = get_global_size(0);                                               \n"
   "   int wg_size = get_local_size(0);                                          \n"
   "   int wg_i = get_local_id(0);                                               \n"
-  "   int wg_num = get_group_id(0);                                             \n"
   "                                                                             \n"
   "   if (i > 0 && i < n-1) {                                                   \n"
   "      out[i] = 0.25*in[i-1] + 0.5*in[i] + 0.25*in[i+1];                      \n"
   "   } else {                                                                  \n"
   "      out[i] = in[i];                                                        \n"
   "   }                                                                         \n"
-  "   stable_l[wg_i] = fabs(in[i] - out[i]) <= eps;                             \n"
+  "   res_l[wg_i] = fabs(in[i] - out[i]);                                       \n"
+  "   barrier(CLK_LOCAL_MEM_FENCE);                                             \n"
+  "                                                                             \n"
   "   for(int offset = 1; offset < wg_size; offset *= 2)                        \n"
   "   {                                                                         \n"
   "      int mask = 2*offset - 1;                                               \n"
-  "      if ((wg_i & mask) == 0)                                                \n"
+  "      if ((wg_i & mask) == 0 && wg_i + offset < wg_size)                     \n"
   "      {                                                                      \n"
-  "         stable_l[wg_i] = stable_l[wg_i] && stable_l[wg_i + offset];         \n"
+  "         res_l[wg_i] = fmax(res_l[wg_i], res_l[wg_i + offset]);              \n"
   "      }                                                                      \n"
+  "      barrier(CLK_LOCAL_MEM_FENCE);                                          \n"
   "   }                                                                         \n"
   "                                                                             \n"
-  "   if(wg_i == 0)                                                             \n"
-  "      stable[wg_num] = stable_l[0];                                          \n"
+  "   if(wg_i == 0 && res_l[0] > eps) {                                         \n"
+  "      atomic_inc(&record[2*slot]);                                           \n"
+  "      atomic_max(&record[2*slot + 1], as_int((float)res_l[0]));              \n"
+  "   }                                                                         \n"
   "}                                                                            \n"
   "\n";
 
@@ -142,8 +175,14 @@ int main()
    size_t local[1];
   
    double *a,*b;
-   bool *stable;
-   int n, count;
+   static int record[2*2*KMAX];     // (unstable groups, residual) per sweep
+   static int zeros[2*KMAX];
+   cl_mem snapshot[2];              // input of the batch, per half
+   cl_event done[2] = {NULL, NULL}; // read of the record, per half
+   int first[2], size[2];           // first sweep and sweeps, per half
+   int n, k, h, j, s, next;
+   int batches = 0;
+   int converged = -1;
    int iterations = 0;
 
    a = allocVector(N);
@@ -153,38 +192,80 @@ int main()
    init(b, N);
 
    n = N;
-   count = 0;
+   k = (CHECK_INTERVAL > 0) ? CHECK_INTERVAL : 1;
+   next = 0;
    
    local[0] = 32;
    printf("work group size: %d\n", (int)local[0]);
    global[0] = n;
    printf("global work size: %d\n\n", n);
 
-   stable = allocStable(N/local[0]);
-   binit(stable, N/local[0]);
-
    printf("size   : %d M (%d MB)\n", n/1000000, (int)(n*sizeof(double) / (1024*1024)));
    printf("heat   : %f\n", HEAT);
    printf("epsilon: %f\n", EPS);
+   if (CHECK_INTERVAL > 0)
+      printf("check  : every %d sweeps", CHECK_INTERVAL);
+   else
+      printf("check  : adaptive (at most every %d sweeps)", KMAX);
+   printf("%s\n", SPECULATE ? ", speculative" : "");
    
    err = initGPU();
    //clPrintDevInfo();
       
    if (err == CL_SUCCESS) {
       clock_gettime(1, &start);
-      kernels = setupKernel(KernelSource, "relax", local[0], 5, DoubleArr, n, a, DoubleArr, n, b, BoolArr, n/local[0], stable, DoubleConst, EPS, IntConst, n);
-
-      do {         
-         if (count == 0) {
-            runKernel(kernels.kernel1, 1, global, local);
-            count++;
-         } else {
-            runKernel(kernels.kernel2, 1, global, local);
-            count--;
+      kernels = setupKernel(KernelSource, "relax", local[0], 6, DoubleArr, n, a, DoubleArr, n, b, IntArr, 2*2*KMAX, record, DoubleConst, EPS, IntConst, n, IntConst, 0);
+      // the record is read asynchronously, the vectors only at the end
+      setTransferPolicy(1, TransferAtEnd, 0);
+      setTransferPolicy(2, TransferAtEnd, 0);
+      setTransferPolicy(3, TransferNever, 0);
+      snapshot[0] = allocDev(sizeof(double) * n);
+      // without speculation only one batch is in flight at a time
+      snapshot[1] = SPECULATE ? allocDev(sizeof(double) * n) : snapshot[0];
+
+      do {
+         // enqueue the next batch; sweep s reads the buffer of argument 1 + s%2
+         h = batches % 2;
+         first[h] = next;
+         size[h] = k;
+         host2devIntArrAsync(zeros, argBuffer(3), 2*h*KMAX, 2*k);
+         if (SPECULATE || k > 1)
+            dev2devDoubleArr(argBuffer(1 + next % 2), snapshot[h], n);
+         for (j = 0; j < k; j++)
+            sweep(kernels, next + j, h*KMAX + j, global, local);
+         done[h] = dev2hostIntArrAsync(argBuffer(3), &record[2*h*KMAX], 2*h*KMAX, 2*k);
+         next += k;
+         batches++;
+
+         // check the oldest batch in flight while the newer one runs
+         if (SPECULATE && batches == 1)
+            continue;
+         h = SPECULATE ? (batches - 2) % 2 : (batches - 1) % 2;
+         waitEvent(done[h]);
+         done[h] = NULL;
+
+         for (j = 0; j < size[h] && converged < 0; j++) {
+            if (isStable(record, h*KMAX + j))
+               converged = first[h] + j;
+         }
+
+         if (converged >= 0 && converged < next - 1) {
+            // roll back the overshoot: replay from the input of the batch up
+            // to the first stable sweep so that a and b hold its in- and output
+            dev2devDoubleArr(snapshot[h], argBuffer(1 + first[h] % 2), n);
+            for (s = first[h]; s <= converged; s++)
+               sweep(kernels, s, h*KMAX + (s - first[h]), global, local);
+         } else if (converged < 0 && CHECK_INTERVAL == 0) {
+            k = nextInterval(record, h*KMAX, size[h]);
          }
-         
-         iterations++;
-      } while(!isStable(stable, n/local[0]));
+      } while (converged < 0);
+      finishKernels();
+      for (h = 0; h < 2; h++) {
+         if (done[h] != NULL)
+            waitEvent(done[h]);
+      }
+      iterations = converged + 1;
+      fetchFinal();
       
       clock_gettime(1, &stop);
       
@@ -192,6 +273,9 @@ int main()
       printTimeElapsed("GPU time spent");
       printKernelTime();
       
+      releaseDev(snapshot[0]);
+      if (SPECULATE)
+         releaseDev(snapshot[1]);
       err = clReleaseKernel(kernels.kernel1);
       err = clReleaseKernel(kernels.kernel2);
       err = freeDevice();
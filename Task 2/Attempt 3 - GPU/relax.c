@@ -141,18 +141,22 @@ int main()
    if (err == CL_SUCCESS) {
       clock_gettime(1, &start);
       kernels = setupKernel(KernelSource, "relax", 5, DoubleArr, n, a, DoubleArr, n, b, BoolArr, 1, stable, DoubleConst, EPS, IntConst, n);
+      // only the stability flags are needed on the host while iterating
+      setTransferPolicy(0, TransferAtEnd, 0);
+      setTransferPolicy(1, TransferAtEnd, 0);
 
       do {         
          if(count == 0) {
-            runKernel(kernels.kernel1, 1, global, local);
+            runKernelSelective(kernels.kernel1, 1, global, local);
             count++;
          } else {
-            runKernel(kernels.kernel2, 1, global, local);
+            runKernelSelective(kernels.kernel2, 1, global, local);
             count--;
          }
          
          iterations++;
       } while(!stable[0]);
+      fetchFinal();
       
       clock_gettime(1, &stop);
       
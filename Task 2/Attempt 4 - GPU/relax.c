@@ -0,0 +1,227 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <math.h>
+#include <string.h>
+#include <CL/cl.h>
+#include <time.h>
+
+#include "simple.h"
+
+#define N 10000000   // length of the vectors
+#define EPS 0.1      // convergence criterium
+#define HEAT 100.0   // heat value on the boundary
+
+#define STEPS 8      // time steps per launch, i.e. width of the halo
+#define WG 256       // work group size, i.e. cells owned per work group
+
+struct timespec start, stop;
+
+void printTimeElapsed(char *text)
+{
+  double elapsed = (stop.tv_sec -start.tv_sec)*1000.0
+                  + (double)(stop.tv_nsec -start.tv_nsec)/1000000.0;
+  printf( "%s: %f msec\n", text, elapsed);
+}
+
+//
+// allocate a double vector of length "n"
+//
+double *allocVector(int n)
+{
+   double *v;
+   v = (double *)malloc( n*sizeof(double));
+   return v;
+}
+
+//
+// initialise the values of the given vector "out" of length "n"
+//
+void init(double *out, int n)
+{
+   int i;
+
+   for(i=1; i<n; i++) {
+      out[i] = 0;
+   }
+   out[0] = HEAT;
+
+}
+
+//
+// print the values of a given vector "out" of length "n"
+//
+void print(double *out, int n)
+{
+   int i;
+
+   printf("<");
+   for( i=0; i<n; i++) {
+      printf(" %f", out[i]);
+   }
+   printf(">\n");
+}
+
+//
+// checks the convergence criterion for time step "t" of the last launch:
+// true, iff no work group found an index i with |out[i] - in[i]| > eps.
+// Each launch records (unstable groups, largest residual) per time step.
+//
+bool isStable(int *record, int t)
+{
+   return record[2*t] == 0;
+}
+
+//
+// relax kernel with temporal blocking: every work group loads the cells it
+// owns plus a halo of "steps" cells on each side into local memory, advances
+// them "steps" time steps there and writes its own cells back once. The halo
+// shrinks by one cell per step, so the owned cells stay exact. "in" is only
+// read, so a launch can be repeated with fewer steps to roll back overshoot.
+//
+const char *KernelSource =                                                     "\n"
+  "__kernel void relax(                                                        \n"
+  "   __local  double* scratch,                                                \n"
+  "   __global double* in,                                                     \n"
+  "   __global double* out,                                                    \n"
+  "   __global int* record,                                                    \n"
+  "   const double eps,                                                        \n"
+  "   const unsigned int count,                                                \n"
+  "   const unsigned int steps)                                                \n"
+  "{                                                                           \n"
+  "   int n = count;                                                           \n"
+  "   int wg_size = get_local_size(0);                                         \n"
+  "   int wg_i = get_local_id(0);                                              \n"
+  "   int base = get_group_id(0) * wg_size;                                    \n"
+  "   int ext = wg_size + 2*steps;                                             \n"
+  "   __local double* cur = scratch;                                           \n"
+  "   __local double* nxt = scratch + ext;                                     \n"
+  "   __local double* res_l = scratch + 2*ext;                                 \n"
+  "   __local double* tmp;                                                     \n"
+  "                                                                            \n"
+  "   for (int c = wg_i; c < ext; c += wg_size) {                              \n"
+  "      int g = base - (int)steps + c;                                        \n"
+  "      cur[c] = (g >= 0 && g < n) ? in[g] : 0.0;                             \n"
+  "   }                                                                        \n"
+  "   barrier(CLK_LOCAL_MEM_FENCE);                                            \n"
+  "                                                                            \n"
+  "   for (int t = 0; t < steps; t++) {                                        \n"
+  "      double r = 0.0;                                                       \n"
+  "      for (int c = t + 1 + wg_i; c < ext - t - 1; c += wg_size) {           \n"
+  "         int g = base - (int)steps + c;                                     \n"
+  "         if (g > 0 && g < n-1) {                                            \n"
+  "            nxt[c] = 0.25*cur[c-1] + 0.5*cur[c] + 0.25*cur[c+1];            \n"
+  "         } else {                                                           \n"
+  "            nxt[c] = cur[c];                                                \n"
+  "         }                                                                  \n"
+  "         if (c >= steps && c < steps + wg_size && g < n)                    \n"
+  "            r = fmax(r, fabs(nxt[c] - cur[c]));                             \n"
+  "      }                                                                     \n"
+  "      res_l[wg_i] = r;                                                      \n"
+  "      barrier(CLK_LOCAL_MEM_FENCE);                                         \n"
+  "                                                                            \n"
+  "      for (int offset = 1; offset < wg_size; offset *= 2) {                 \n"
+  "         int mask = 2*offset - 1;                                           \n"
+  "         if ((wg_i & mask) == 0 && wg_i + offset < wg_size)                 \n"
+  "            res_l[wg_i] = fmax(res_l[wg_i], res_l[wg_i + offset]);          \n"
+  "         barrier(CLK_LOCAL_MEM_FENCE);                                      \n"
+  "      }                                                                     \n"
+  "      if (wg_i == 0 && res_l[0] > eps) {                                    \n"
+  "         atomic_inc(&record[2*t]);                                          \n"
+  "         atomic_max(&record[2*t + 1], as_int((float)res_l[0]));             \n"
+  "      }                                                                     \n"
+  "                                                                            \n"
+  "      tmp = cur;                                                            \n"
+  "      cur = nxt;                                                            \n"
+  "      nxt = tmp;                                                            \n"
+  "   }                                                                        \n"
+  "                                                                            \n"
+  "   if (base + wg_i < n)                                                     \n"
+  "      out[base + wg_i] = cur[steps + wg_i];                                 \n"
+  "}                                                                           \n"
+  "\n";
+
+int main()
+{
+   cl_int err;
+   kernel_struct kernels;
+   cl_kernel kernel;
+   size_t global[1];
+   size_t local[1];
+  
+   double *a,*b;
+   static int record[2*STEPS];
+   static int zeros[2*STEPS];
+   int n, t;
+   int launches = 0;
+   int converged = -1;
+   int iterations = 0;
+
+   a = allocVector(N);
+   b = allocVector(N);
+
+   init(a, N);
+   init(b, N);
+
+   n = N;
+   
+   local[0] = WG;
+   printf("work group size: %d\n", (int)local[0]);
+   global[0] = ((n + WG - 1) / WG) * WG;
+   printf("global work size: %d\n", (int)global[0]);
+   printf("time steps per launch: %d\n\n", STEPS);
+
+   printf("size   : %d M (%d MB)\n", n/1000000, (int)(n*sizeof(double) / (1024*1024)));
+   printf("heat   : %f\n", HEAT);
+   printf("epsilon: %f\n", EPS);
+   
+   err = initGPU();
+   //clPrintDevInfo();
+      
+   if (err == CL_SUCCESS) {
+      clock_gettime(1, &start);
+      // local memory: two tiles of WG + 2*STEPS cells and the reduction
+      kernels = setupKernel(KernelSource, "relax", 2*(WG + 2*STEPS) + WG, 6, DoubleArr, n, a, DoubleArr, n, b, IntArr, 2*STEPS, record, DoubleConst, EPS, IntConst, n, IntConst, STEPS);
+      setTransferPolicy(1, TransferAtEnd, 0);
+      setTransferPolicy(2, TransferAtEnd, 0);
+      setTransferPolicy(3, TransferOnDemand, 0);
+
+      do {
+         kernel = (launches % 2 == 0) ? kernels.kernel1 : kernels.kernel2;
+         host2devIntArrAsync(zeros, argBuffer(3), 0, 2*STEPS);
+         enqueueKernel(kernel, 1, global, local);
+         finishKernels();
+         fetchArg(3);
+
+         for (t = 0; t < STEPS && converged < 0; t++) {
+            if (isStable(record, t))
+               converged = iterations + t;
+         }
+
+         if (converged >= 0 && converged < iterations + STEPS - 1) {
+            // roll back the overshoot: the input of the launch is untouched,
+            // so repeat it with just the steps up to the first stable one
+            setKernelIntArg(kernel, 6, converged - iterations + 1);
+            enqueueKernel(kernel, 1, global, local);
+            finishKernels();
+            setKernelIntArg(kernel, 6, STEPS);
+         }
+         iterations = (converged >= 0) ? converged + 1 : iterations + STEPS;
+         launches++;
+      } while (converged < 0);
+      // the result is in b after an odd number of launches, in a otherwise
+      fetchFinal();
+      
+      clock_gettime(1, &stop);
+      
+      printf("Number of iterations: %d\n", iterations);
+      printTimeElapsed("GPU time spent");
+      printKernelTime();
+      
+      err = clReleaseKernel(kernels.kernel1);
+      err = clReleaseKernel(kernels.kernel2);
+      err = freeDevice();
+   }
+
+   return 0;
+}
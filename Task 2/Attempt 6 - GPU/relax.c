@@ -0,0 +1,443 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <math.h>
+#include <time.h>
+#include <CL/cl.h>
+#include "simple.h"
+
+#define N 10000000   // length of the vectors
+#define EPS 0.1      // convergence criterium
+#define HEAT 100.0   // heat value on the boundary
+#define NU1 2           // smoothing sweeps before the coarse grid correction
+#define NU2 2           // smoothing sweeps after it
+#define COARSE_SWEEPS 40   // sweeps on the coarsest grid (at most 3 points)
+#define MAX_LEVELS 40
+#define LOCAL 32        // work group size
+
+struct timespec start, stop;
+
+void printTimeElapsed(char *text)
+{
+  double elapsed = (stop.tv_sec -start.tv_sec)*1000.0
+                  + (double)(stop.tv_nsec -start.tv_nsec)/1000000.0;
+  printf( "%s: %f msec\n", text, elapsed);
+}
+
+//
+// allocate a vector of length "n"
+//
+double *allocVector(int n)
+{
+   double *v;
+   v = (double *)malloc( n*sizeof(double));
+   return v;
+}
+
+//
+// allocate a bool vector of length "n"
+//
+bool *allocStable(int n)
+{
+   bool *s;
+   s = (bool *)malloc( n*sizeof(bool));
+   return s;
+}
+
+//
+// initialise the values of the given vector "out" of length "n"
+//
+void init(double *out, int n)
+{
+   int i;
+
+   for(i=1; i<n; i++) {
+      out[i] = 0;
+   }
+   out[0] = HEAT;
+}
+
+//
+// initialise the values of the given vector "out" of length "n"
+//
+void binit(bool *out, int n)
+{
+   int i;
+
+   for(i=0; i<n; i++) {
+      out[i] = false;
+   }
+}
+
+//
+// print the values of a given vector "out" of length "n"
+//
+void print(double *out, int n)
+{
+   int i;
+
+   printf("<");
+   for(i=0; i<n; i++) {
+      printf(" %f", out[i]);
+   }
+   printf(">\n");
+}
+
+//
+// multigrid kernels for the steady state of the relax stencil, i.e. for
+// -u'' = f with fixed end points. Level l has the points 0, h, 2h, ... of
+// the finest grid (h = 2^l) plus its last point, so only its last cell has
+// a different length d; apply() is the finite difference -u'' for that.
+// - smooth: one damped Jacobi sweep, u += h*hr/4 * (f - apply(u)); on the
+//   finest grid (h = d = 1, f = 0) this is the relax stencil,
+//   including the stability check
+// - restrict_residual: full weighting of the residual f - apply(u) onto the
+//   coarse grid, whose point j is fine point 2j (the last one is the last
+//   fine point); the residual at the fixed end points is 0
+// - prolong: linear interpolation of the coarse grid values, added to the
+//   fine grid as a correction (add != 0) or used as its initial guess
+// - fill: zero the interior and set the two end points
+//
+const char *KernelSource =                                                 "\n"
+  "double apply(__global double* u, int i, int n, double h, double d)      \n"
+  "{                                                                       \n"
+  "   double hr = (i == n-2) ? d : h;                                      \n"
+  "   return 2.0/(h+hr) * ((u[i] - u[i-1])/h + (u[i] - u[i+1])/hr);        \n"
+  "}                                                                       \n"
+  "                                                                        \n"
+  "__kernel void smooth(                                                   \n"
+  "   __global double* in,                                                 \n"
+  "   __global double* out,                                                \n"
+  "   __global double* f,                                                  \n"
+  "   __global bool* stable,                                               \n"
+  "   const double eps,                                                    \n"
+  "   const unsigned int count,                                            \n"
+  "   const double h,                                                      \n"
+  "   const double d)                                                      \n"
+  "{                                                                       \n"
+  "   int i = get_global_id(0);                                            \n"
+  "   int n = count;                                                       \n"
+  "   if (i >= n)                                                          \n"
+  "      return;                                                           \n"
+  "   if (i > 0 && i < n-1) {                                              \n"
+  "      double hr = (i == n-2) ? d : h;                                   \n"
+  "      out[i] = in[i] + 0.25*h*hr*(f[i] - apply(in, i, n, h, d));        \n"
+  "   } else {                                                             \n"
+  "      out[i] = in[i];                                                   \n"
+  "   }                                                                    \n"
+  "   if (fabs(in[i] - out[i]) > eps)                                      \n"
+  "      stable[0] = false;                                                \n"
+  "}                                                                       \n"
+  "                                                                        \n"
+  "__kernel void restrict_residual(                                        \n"
+  "   __global double* u,                                                  \n"
+  "   __global double* f,                                                  \n"
+  "   __global double* fc,                                                 \n"
+  "   const unsigned int count,                                            \n"
+  "   const unsigned int coarse,                                           \n"
+  "   const double h,                                                      \n"
+  "   const double d)                                                      \n"
+  "{                                                                       \n"
+  "   int j = get_global_id(0);                                            \n"
+  "   int n = count;                                                       \n"
+  "   int nc = coarse;                                                     \n"
+  "   int i = 2*j;                                                         \n"
+  "   double r, w;                                                         \n"
+  "   if (j >= nc)                                                         \n"
+  "      return;                                                           \n"
+  "   if (j == 0 || j == nc-1) {                                           \n"
+  "      fc[j] = 0.0;                                                      \n"
+  "   } else {                                                             \n"
+  "      r = 0.25*(f[i-1] - apply(u, i-1, n, h, d))                        \n"
+  "          + 0.5*(f[i] - apply(u, i, n, h, d));                          \n"
+  "      w = 0.75;                                                         \n"
+  "      if (i+1 < n-1) {                                                  \n"
+  "         r += 0.25*(f[i+1] - apply(u, i+1, n, h, d));                   \n"
+  "         w += 0.25;                                                     \n"
+  "      }                                                                 \n"
+  "      fc[j] = r / w;                                                    \n"
+  "   }                                                                    \n"
+  "}                                                                       \n"
+  "                                                                        \n"
+  "__kernel void prolong(                                                  \n"
+  "   __global double* u,                                                  \n"
+  "   __global double* uc,                                                 \n"
+  "   const unsigned int count,                                            \n"
+  "   const unsigned int add,                                              \n"
+  "   const double h,                                                      \n"
+  "   const double d)                                                      \n"
+  "{                                                                       \n"
+  "   int i = get_global_id(0);                                            \n"
+  "   int n = count;                                                       \n"
+  "   double e, hr;                                                        \n"
+  "   if (i <= 0 || i >= n-1)                                              \n"
+  "      return;                                                           \n"
+  "   if (i % 2 == 0) {                                                    \n"
+  "      e = uc[i/2];                                                      \n"
+  "   } else {                                                             \n"
+  "      hr = (i+1 == n-1) ? d : h;                                        \n"
+  "      e = (hr*uc[(i-1)/2] + h*uc[(i+1)/2]) / (h+hr);                    \n"
+  "   }                                                                    \n"
+  "   u[i] = add ? u[i] + e : e;                                           \n"
+  "}                                                                       \n"
+  "                                                                        \n"
+  "__kernel void fill(                                                     \n"
+  "   __global double* u,                                                  \n"
+  "   const double left,                                                   \n"
+  "   const double right,                                                  \n"
+  "   const unsigned int count)                                            \n"
+  "{                                                                       \n"
+  "   int i = get_global_id(0);                                            \n"
+  "   int n = count;                                                       \n"
+  "   if (i < n)                                                           \n"
+  "      u[i] = (i == 0) ? left : ((i == n-1) ? right : 0.0);              \n"
+  "}                                                                       \n"
+  "\n";
+
+typedef struct {
+   int levels;
+   int n[MAX_LEVELS];
+   double h[MAX_LEVELS];      // mesh width, in cells of the finest grid
+   double d[MAX_LEVELS];      // length of the last cell
+   cl_mem u[MAX_LEVELS];      // current approximation per level
+   cl_mem tmp[MAX_LEVELS];    // second vector for the Jacobi sweeps
+   cl_mem f[MAX_LEVELS];      // right hand side per level
+   cl_mem stable;
+   cl_kernel smooth, restrict_residual, prolong, fill;
+   double work;               // work units: passes over the finest grid
+   cl_int err;                // first failed command; nothing runs after it
+} grid;
+
+//
+// global work size for "n" items, rounded up to a multiple of LOCAL
+//
+size_t globalSize(int n)
+{
+   return ((n + LOCAL - 1) / LOCAL) * LOCAL;
+}
+
+//
+// set argument "i" of kernel "k", unless a command has failed already
+//
+void setArg(grid *g, cl_kernel k, cl_uint i, size_t size, const void *value)
+{
+   if (g->err != CL_SUCCESS)
+      return;
+   g->err = clSetKernelArg(k, i, size, value);
+   if (g->err != CL_SUCCESS)
+      fprintf(stderr, "Error: Failed to set kernel arg %d!\n", i);
+}
+
+//
+// enqueue "k" with one work item per point of level "l" and count its work;
+// the queue is in order, so the launches need not wait for each other
+//
+void launch(grid *g, cl_kernel k, int l)
+{
+   size_t global[1];
+   size_t local[1];
+
+   if (g->err != CL_SUCCESS)
+      return;
+   global[0] = globalSize(g->n[l]);
+   local[0] = LOCAL;
+   g->err = enqueueKernel(k, 1, global, local);
+   g->work += (double)g->n[l] / g->n[0];
+}
+
+//
+// "sweeps" smoothing sweeps on level "l"; the result stays in g->u[l]
+//
+void smooth(grid *g, int l, int sweeps, double eps)
+{
+   cl_mem t;
+   unsigned int n = g->n[l];
+   int s;
+
+   for (s = 0; s < sweeps; s++) {
+      setArg(g, g->smooth, 0, sizeof(cl_mem), &g->u[l]);
+      setArg(g, g->smooth, 1, sizeof(cl_mem), &g->tmp[l]);
+      setArg(g, g->smooth, 2, sizeof(cl_mem), &g->f[l]);
+      setArg(g, g->smooth, 3, sizeof(cl_mem), &g->stable);
+      setArg(g, g->smooth, 4, sizeof(double), &eps);
+      setArg(g, g->smooth, 5, sizeof(unsigned int), &n);
+      setArg(g, g->smooth, 6, sizeof(double), &g->h[l]);
+      setArg(g, g->smooth, 7, sizeof(double), &g->d[l]);
+      launch(g, g->smooth, l);
+      t = g->u[l];
+      g->u[l] = g->tmp[l];
+      g->tmp[l] = t;
+   }
+}
+
+void fill(grid *g, cl_mem u, int l, double left, double right)
+{
+   unsigned int n = g->n[l];
+
+   setArg(g, g->fill, 0, sizeof(cl_mem), &u);
+   setArg(g, g->fill, 1, sizeof(double), &left);
+   setArg(g, g->fill, 2, sizeof(double), &right);
+   setArg(g, g->fill, 3, sizeof(unsigned int), &n);
+   launch(g, g->fill, l);
+}
+
+//
+// interpolate level l+1 into level l: as correction or as initial guess
+//
+void prolong(grid *g, int l, unsigned int add)
+{
+   unsigned int n = g->n[l];
+
+   setArg(g, g->prolong, 0, sizeof(cl_mem), &g->u[l]);
+   setArg(g, g->prolong, 1, sizeof(cl_mem), &g->u[l+1]);
+   setArg(g, g->prolong, 2, sizeof(unsigned int), &n);
+   setArg(g, g->prolong, 3, sizeof(unsigned int), &add);
+   setArg(g, g->prolong, 4, sizeof(double), &g->h[l]);
+   setArg(g, g->prolong, 5, sizeof(double), &g->d[l]);
+   launch(g, g->prolong, l);
+}
+
+//
+// one V-cycle on level "l" for A u[l] = f[l]
+//
+void vcycle(grid *g, int l)
+{
+   unsigned int n = g->n[l];
+   unsigned int nc;
+
+   if (l == g->levels - 1) {
+      smooth(g, l, COARSE_SWEEPS, INFINITY);
+      return;
+   }
+   nc = g->n[l+1];
+
+   smooth(g, l, NU1, INFINITY);
+   setArg(g, g->restrict_residual, 0, sizeof(cl_mem), &g->u[l]);
+   setArg(g, g->restrict_residual, 1, sizeof(cl_mem), &g->f[l]);
+   setArg(g, g->restrict_residual, 2, sizeof(cl_mem), &g->f[l+1]);
+   setArg(g, g->restrict_residual, 3, sizeof(unsigned int), &n);
+   setArg(g, g->restrict_residual, 4, sizeof(unsigned int), &nc);
+   setArg(g, g->restrict_residual, 5, sizeof(double), &g->h[l]);
+   setArg(g, g->restrict_residual, 6, sizeof(double), &g->d[l]);
+   launch(g, g->restrict_residual, l+1);
+   fill(g, g->u[l+1], l+1, 0.0, 0.0);
+   vcycle(g, l+1);
+   prolong(g, l, 1);
+   smooth(g, l, NU2, INFINITY);
+}
+
+int main()
+{
+   cl_int err;
+   grid g;
+  
+   double *a;
+   bool *stable;
+   bool yes = true;
+   int n, l;
+   int iterations = 0;
+
+   a = allocVector(N);
+   stable = allocStable(1);
+
+   init(a, N);
+   binit(stable, 1);
+
+   n = N;
+
+   // every level keeps every other point of the one above and its last one
+   g.levels = 1;
+   g.n[0] = n;
+   g.h[0] = 1.0;
+   g.d[0] = 1.0;
+   while (g.n[g.levels-1] > 3 && g.levels < MAX_LEVELS) {
+      l = g.levels++;
+      g.n[l] = g.n[l-1]/2 + 1;
+      g.h[l] = 2.0 * g.h[l-1];
+      g.d[l] = (g.n[l-1] % 2 == 1) ? g.h[l-1] + g.d[l-1] : g.d[l-1];
+   }
+   g.work = 0.0;
+   g.err = CL_SUCCESS;
+
+   printf("work group size: %d\n", LOCAL);
+   printf("grid levels: %d (coarsest %d points)\n\n", g.levels, g.n[g.levels-1]);
+
+   printf("size   : %d M (%d MB)\n", n/1000000, (int)(n*sizeof(double) / (1024*1024)));
+   printf("heat   : %f\n", HEAT);
+   printf("epsilon: %f\n", EPS);
+   
+   err = initGPU();
+   //clPrintDevInfo();
+      
+   if (err == CL_SUCCESS) {
+      clock_gettime(1, &start);
+      g.smooth = createKernel(KernelSource, "smooth");
+      g.restrict_residual = createKernel(KernelSource, "restrict_residual");
+      g.prolong = createKernel(KernelSource, "prolong");
+      g.fill = createKernel(KernelSource, "fill");
+      g.stable = allocDev(sizeof(bool));
+      if (g.smooth == NULL || g.restrict_residual == NULL
+          || g.prolong == NULL || g.fill == NULL)
+         g.err = CL_INVALID_KERNEL;
+      for (l = 0; l < g.levels; l++) {
+         g.u[l] = allocDev(sizeof(double) * g.n[l]);
+         g.tmp[l] = allocDev(sizeof(double) * g.n[l]);
+         g.f[l] = allocDev(sizeof(double) * g.n[l]);
+         fill(&g, g.f[l], l, 0.0, 0.0);
+      }
+
+      // full multigrid: solve on the coarsest grid with the boundary values
+      // of the finest, then interpolate and V-cycle level by level
+      host2devDoubleArr(a, g.u[0], n);
+      for (l = 1; l < g.levels; l++)
+         fill(&g, g.u[l], l, a[0], a[n-1]);
+      smooth(&g, g.levels-1, COARSE_SWEEPS, INFINITY);
+      for (l = g.levels-2; l >= 0; l--) {
+         prolong(&g, l, 0);
+         vcycle(&g, l);
+      }
+      iterations++;
+
+      // V-cycles until a relax sweep on the finest grid is stable; all
+      // levels are only enqueued, the host waits for the flag alone
+      while (g.err == CL_SUCCESS) {
+         host2devBoolArrAsync(&yes, g.stable, 1);
+         smooth(&g, 0, 1, EPS);
+         if (g.err != CL_SUCCESS)
+            break;
+         dev2hostBoolArr(g.stable, stable, 1);
+         g.err = finishKernels();
+         if (stable[0])
+            break;
+         vcycle(&g, 0);
+         iterations++;
+      }
+      if (g.err != CL_SUCCESS) {
+         printf("V-cycle %d failed\n", iterations);
+         finishKernels();
+         return 1;
+      }
+      dev2hostDoubleArr(g.u[0], a, n);
+      
+      clock_gettime(1, &stop);
+      
+      printf("Number of iterations: %d (V-cycles, the first one as FMG)\n", iterations);
+      printf("Work units: %f (kernel passes over the finest grid)\n", g.work);
+      printTimeElapsed("GPU time spent");
+      printKernelTime();
+      
+      for (l = 0; l < g.levels; l++) {
+         releaseDev(g.u[l]);
+         releaseDev(g.tmp[l]);
+         releaseDev(g.f[l]);
+      }
+      releaseDev(g.stable);
+      err = clReleaseKernel(g.smooth);
+      err = clReleaseKernel(g.restrict_residual);
+      err = clReleaseKernel(g.prolong);
+      err = clReleaseKernel(g.fill);
+      err = freeDevice();
+   }
+
+   return 0;
+}
@@ -0,0 +1,893 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <CL/cl.h>
+#include "simple.h"
+
+typedef struct {
+  clarg_type arg_t;
+  cl_mem dev_buf;
+  double *dhost_buf;
+  float *host_buf;
+  bool  *bhost_buf;
+  int    num_elems;
+  double eps;
+  int    val;
+  transfer_policy policy;
+  int    every;
+} kernel_arg;
+
+#define MAX_ARG 10
+
+#define CACHE_ENV "HEAT_CL_CACHE"
+#define CACHE_DEFAULT_DIR ".clcache"
+
+#define die(msg, ...) do {                      \
+  (void) fprintf (stderr, msg, ## __VA_ARGS__); \
+  (void) fprintf (stderr, "\n");                \
+} while (0)
+
+/* global setup */
+
+static cl_platform_id cpPlatform;     /* openCL platform.  */
+static cl_device_id device_id;        /* Compute device id.  */
+static cl_context context;            /* Compute context.  */
+static cl_command_queue commands;     /* Compute command queue.  */
+static cl_program program;            /* Compute program.  */
+static int num_kernel_args;
+static int num_runs;
+static kernel_arg kernel_args[MAX_ARG];
+
+static struct timespec start, stop;
+static double kernel_time = 0.0;
+static bool kernels_pending = false;
+
+/* command profiling (HEAT_CL_PROFILE) */
+
+#define PROF_ENV "HEAT_CL_PROFILE"
+#define PROF_MAX 256
+#define PROF_EVENT(ev) (profiling ? &(ev) : NULL)
+
+typedef enum {
+  ProfKernel,
+  ProfWrite,
+  ProfRead,
+  ProfCopy,
+  PROF_TYPES
+} prof_type;
+
+static const char *prof_names[PROF_TYPES] = { "kernel", "write", "read", "copy" };
+
+typedef struct {
+  long   count;
+  double queued;    /* queued -> submit, msec.  */
+  double submit;    /* submit -> start, msec.  */
+  double run;       /* start -> end, msec.  */
+} prof_sum;
+
+static bool profiling = false;
+static cl_event prof_events[PROF_MAX];
+static prof_type prof_types[PROF_MAX];
+static int prof_pending = 0;
+static prof_sum prof_sums[PROF_TYPES];
+
+static void profFlush()
+{
+  cl_ulong t[4];
+  int i, j;
+
+  for (i = 0; i < prof_pending; i++) {
+    if (CL_SUCCESS != clWaitForEvents (1, &prof_events[i])) {
+      die ("Error: Failed to wait for a profiled command!");
+    } else {
+      for (j = 0; j < 4; j++) {
+        t[j] = 0;
+        clGetEventProfilingInfo (prof_events[i], CL_PROFILING_COMMAND_QUEUED + j,
+                                 sizeof (cl_ulong), &t[j], NULL);
+      }
+      prof_sums[prof_types[i]].count++;
+      prof_sums[prof_types[i]].queued += (t[1] - t[0]) / 1000000.0;
+      prof_sums[prof_types[i]].submit += (t[2] - t[1]) / 1000000.0;
+      prof_sums[prof_types[i]].run += (t[3] - t[2]) / 1000000.0;
+    }
+    clReleaseEvent (prof_events[i]);
+  }
+  prof_pending = 0;
+}
+
+/* Takes over the event of a command enqueued with PROF_EVENT.  */
+static void profRecord( cl_event ev, prof_type type)
+{
+  if (ev == NULL)
+    return;
+  if (!profiling) {
+    clReleaseEvent (ev);
+    return;
+  }
+  if (prof_pending == PROF_MAX)
+    profFlush ();
+  prof_events[prof_pending] = ev;
+  prof_types[prof_pending] = type;
+  prof_pending++;
+}
+
+cl_int initDevice ( int devType)
+{
+  cl_int err = CL_SUCCESS;
+  cl_uint num_platforms;
+  cl_platform_id *cpPlatforms;
+
+  /* Connect to a compute device.  */
+  err = clGetPlatformIDs (0, NULL, &num_platforms);
+  if (CL_SUCCESS != err) {
+    die ("Error: Failed to find a platform!");
+  } else {
+    cpPlatforms = (cl_platform_id *)malloc( sizeof( cl_platform_id)*num_platforms);
+    err = clGetPlatformIDs(num_platforms, cpPlatforms, NULL);
+
+    for(unsigned int i=0; i<num_platforms; i++){
+        err = clGetDeviceIDs(cpPlatforms[i], devType, 1, &device_id, NULL);
+        if (err == CL_SUCCESS ) {
+           cpPlatform = cpPlatforms[i];
+           break;
+        }
+    }
+    if (CL_SUCCESS != err) {
+      die ("Error: Failed to create a device group!");
+    } else { 
+      profiling = (getenv (PROF_ENV) != NULL) && (strcmp (getenv (PROF_ENV), "0") != 0);
+
+      /* Create a compute context.  */
+      context = clCreateContext (0, 1, &device_id, NULL, NULL, &err);
+      if (!context || err != CL_SUCCESS) {
+        die ("Error: Failed to create a compute context!");
+      } else {
+        /* Create a command commands.  */
+        commands = clCreateCommandQueue (context, device_id,
+                                         profiling ? CL_QUEUE_PROFILING_ENABLE : 0, &err);
+        if (!commands || err != CL_SUCCESS) {
+          die ("Error: Failed to create a command commands!");
+        }
+      }
+    }
+  }
+
+ return err;
+}
+
+cl_int initCPU ()
+{
+  return initDevice( CL_DEVICE_TYPE_CPU);
+}
+
+cl_int initGPU ()
+{
+  return initDevice( CL_DEVICE_TYPE_GPU);
+}
+
+size_t maxWorkItems( int dim)
+{
+   cl_int err = CL_SUCCESS;
+   size_t maxWI = 0;
+   size_t max[3];
+
+   if( dim >= 0 && dim < 3) {
+      err = clGetDeviceInfo(device_id,
+                            CL_DEVICE_MAX_WORK_ITEM_SIZES,
+                            3*sizeof(size_t),
+                            &max,
+                            NULL);
+      if (CL_SUCCESS != err) {
+         die ("Error: Failed to get device info on work item sizes!");
+      } else {
+         maxWI = max[dim];
+      }
+   } else {
+      die ("Error: maxWorkItems called with illegal parameter!");
+   }
+
+  return maxWI;
+}
+
+/* device buffer pool */
+
+#define POOL_MAX 16          /* Free buffers kept for reuse.  */
+#define POOL_MIN_BYTES 64    /* Smallest size class.  */
+
+static cl_mem pool_mems[POOL_MAX];
+static size_t pool_sizes[POOL_MAX];
+static int pool_count = 0;
+static long pool_requests = 0;
+static long pool_hits = 0;
+static size_t live_bytes = 0;
+static size_t peak_bytes = 0;
+
+/* Size class of a request for n bytes: n rounded up to an eighth of its
+   leading power of two, so no class wastes more than 12.5%.  */
+static size_t sizeClass( size_t n)
+{
+  size_t p = POOL_MIN_BYTES;
+
+  if (n <= POOL_MIN_BYTES)
+    return POOL_MIN_BYTES;
+  while (p * 2 <= n)
+    p *= 2;
+  return ((n + p/8 - 1) / (p/8)) * (p/8);
+}
+
+cl_mem allocDev( size_t n)
+{
+   cl_int err = CL_SUCCESS;
+   cl_mem mem = NULL;
+   size_t size = sizeClass (n);
+
+   pool_requests++;
+   for (int i = 0; i < pool_count; i++) {
+      if (pool_sizes[i] == size) {
+         mem = pool_mems[i];
+         pool_count--;
+         pool_mems[i] = pool_mems[pool_count];
+         pool_sizes[i] = pool_sizes[pool_count];
+         pool_hits++;
+         break;
+      }
+   }
+
+   if (mem == NULL) {
+      mem = clCreateBuffer (context, CL_MEM_READ_WRITE, size, NULL, &err);
+      if( err != CL_SUCCESS) {
+         die ("Error %d", err);
+         die ("Error: Failed to allocate device memory!");
+         return mem;
+      }
+   }
+   live_bytes += size;
+   if (live_bytes > peak_bytes)
+      peak_bytes = live_bytes;
+
+   return mem;
+}
+
+void releaseDev( cl_mem mem)
+{
+   size_t size = 0;
+   cl_mem_flags flags = 0;
+
+   if (mem == NULL)
+      return;
+   clGetMemObjectInfo (mem, CL_MEM_SIZE, sizeof (size), &size, NULL);
+   clGetMemObjectInfo (mem, CL_MEM_FLAGS, sizeof (flags), &flags, NULL);
+   if (flags & CL_MEM_USE_HOST_PTR) {
+      /* Wraps host memory: not from the pool.  */
+      clReleaseMemObject (mem);
+      return;
+   }
+
+   live_bytes -= size;
+   if (pool_count < POOL_MAX) {
+      pool_mems[pool_count] = mem;
+      pool_sizes[pool_count] = size;
+      pool_count++;
+   } else {
+      clReleaseMemObject (mem);
+   }
+}
+
+static void drainPool()
+{
+  for (int i = 0; i < pool_count; i++)
+    clReleaseMemObject (pool_mems[i]);
+  pool_count = 0;
+}
+
+void host2devDoubleArr( double *a, cl_mem ad, size_t n)
+{
+   cl_int err = CL_SUCCESS;
+   cl_event ev = NULL;
+
+   err = clEnqueueWriteBuffer( commands, ad, CL_TRUE, 0,
+                               sizeof (double) * n,
+                               a, 0, NULL, PROF_EVENT (ev));
+   profRecord (ev, ProfWrite);
+   if( CL_SUCCESS != err) {
+      die ("Error: Failed to transfer from host to device!");
+   }
+}
+
+void host2devFloatArr( float *a, cl_mem ad, size_t n)
+{
+   cl_int err = CL_SUCCESS;
+   cl_event ev = NULL;
+
+   err = clEnqueueWriteBuffer( commands, ad, CL_TRUE, 0,
+                               sizeof (float) * n,
+                               a, 0, NULL, PROF_EVENT (ev));
+   profRecord (ev, ProfWrite);
+   if( CL_SUCCESS != err) {
+      die ("Error: Failed to transfer from host to device!");
+   }
+}
+
+void host2devBoolArr( bool *a, cl_mem ad, size_t n)
+{
+   cl_int err = CL_SUCCESS;
+   cl_event ev = NULL;
+
+   err = clEnqueueWriteBuffer( commands, ad, CL_TRUE, 0,
+                               sizeof (bool) * n,
+                               a, 0, NULL, PROF_EVENT (ev));
+   profRecord (ev, ProfWrite);
+   if( CL_SUCCESS != err) {
+      die ("Error: Failed to transfer from host to device!");
+   }
+}
+
+void host2devBoolArrAsync( bool *a, cl_mem ad, size_t n)
+{
+   cl_int err = CL_SUCCESS;
+   cl_event ev = NULL;
+
+   err = clEnqueueWriteBuffer( commands, ad, CL_FALSE, 0,
+                               sizeof (bool) * n,
+                               a, 0, NULL, PROF_EVENT (ev));
+   profRecord (ev, ProfWrite);
+   if( CL_SUCCESS != err) {
+      die ("Error: Failed to transfer from host to device!");
+   }
+}
+
+void dev2hostDoubleArr( cl_mem ad, double *a, size_t n)
+{
+   cl_int err = CL_SUCCESS;
+   cl_event ev = NULL;
+
+   err = clEnqueueReadBuffer (commands, ad, CL_TRUE, 0,
+                              sizeof (double) * n,
+                              a, 0, NULL, PROF_EVENT (ev));
+   profRecord (ev, ProfRead);
+   if( CL_SUCCESS != err) {
+      die ("Error: Failed to transfer from device to host!");
+   }
+}
+
+void dev2hostFloatArr( cl_mem ad, float *a, size_t n)
+{
+   cl_int err = CL_SUCCESS;
+   cl_event ev = NULL;
+
+   err = clEnqueueReadBuffer (commands, ad, CL_TRUE, 0,
+                              sizeof (float) * n,
+                              a, 0, NULL, PROF_EVENT (ev));
+   profRecord (ev, ProfRead);
+   if( CL_SUCCESS != err) {
+      die ("Error: Failed to transfer from device to host!");
+   }
+}
+
+void dev2hostBoolArr( cl_mem ad, bool *a, size_t n)
+{
+   cl_int err = CL_SUCCESS;
+   cl_event ev = NULL;
+
+   err = clEnqueueReadBuffer (commands, ad, CL_TRUE, 0,
+                              sizeof (bool) * n,
+                              a, 0, NULL, PROF_EVENT (ev));
+   profRecord (ev, ProfRead);
+   if( CL_SUCCESS != err) {
+      die ("Error: Failed to transfer from device to host!");
+   }
+}
+
+/* program binary cache */
+
+static char *program_source = NULL;   /* Source the program was built from.  */
+
+static const char *cacheDir()
+{
+  const char *dir = getenv (CACHE_ENV);
+
+  return (dir == NULL) ? CACHE_DEFAULT_DIR : dir;
+}
+
+static unsigned long long hashAppend( unsigned long long h, const char *s)
+{
+  /* 64-bit FNV-1a; the terminating 0 separates the fields.  */
+  do {
+    h ^= (unsigned char) *s;
+    h *= 1099511628211ULL;
+  } while (*s++ != '\0');
+
+  return h;
+}
+
+static bool cachePath( const char *kernel_source, const char *options,
+                       char *path, size_t len)
+{
+  char device_name[1024];
+  char driver_version[256];
+  unsigned long long h = 14695981039346656037ULL;
+  const char *dir = cacheDir ();
+
+  if (dir[0] == '\0')
+    return false;
+  if (CL_SUCCESS != clGetDeviceInfo (device_id, CL_DEVICE_NAME,
+                                     sizeof (device_name), device_name, NULL)
+      || CL_SUCCESS != clGetDeviceInfo (device_id, CL_DRIVER_VERSION,
+                                        sizeof (driver_version), driver_version, NULL))
+    return false;
+
+  h = hashAppend (h, kernel_source);
+  h = hashAppend (h, (options == NULL) ? "" : options);
+  h = hashAppend (h, device_name);
+  h = hashAppend (h, driver_version);
+
+  return snprintf (path, len, "%s/%016llx.bin", dir, h) < (int) len;
+}
+
+static cl_program loadProgramBinary( const char *path)
+{
+  cl_program prog = NULL;
+  cl_int err = CL_SUCCESS;
+  cl_int status = CL_SUCCESS;
+  unsigned char *binary = NULL;
+  size_t size = 0;
+  long end;
+  FILE *f;
+
+  f = fopen (path, "rb");
+  if (f == NULL)
+    return NULL;
+
+  if ((fseek (f, 0, SEEK_END) == 0) && ((end = ftell (f)) > 0)
+       && (fseek (f, 0, SEEK_SET) == 0)) {
+    size = (size_t) end;
+    binary = (unsigned char *) malloc (size);
+    if ((binary != NULL) && (fread (binary, 1, size, f) == size)) {
+      prog = clCreateProgramWithBinary (context, 1, &device_id, &size,
+                                        (const unsigned char **) &binary,
+                                        &status, &err);
+      if ((prog != NULL) && ((err != CL_SUCCESS) || (status != CL_SUCCESS))) {
+        clReleaseProgram (prog);
+        prog = NULL;
+      }
+    }
+    free (binary);
+  }
+  fclose (f);
+
+  return prog;
+}
+
+static void storeProgramBinary( cl_program prog, const char *path)
+{
+  unsigned char *binary;
+  size_t size = 0;
+  char tmp_path[1100];
+  bool written;
+  FILE *f;
+
+  if ((CL_SUCCESS != clGetProgramInfo (prog, CL_PROGRAM_BINARY_SIZES,
+                                       sizeof (size), &size, NULL))
+       || (size == 0))
+    return;
+
+  binary = (unsigned char *) malloc (size);
+  if (binary == NULL)
+    return;
+
+  if (CL_SUCCESS == clGetProgramInfo (prog, CL_PROGRAM_BINARIES,
+                                      sizeof (binary), &binary, NULL)) {
+    /* Write to a private file first so that concurrent runs never see a
+       partially written binary.  */
+    mkdir (cacheDir (), 0755);
+    snprintf (tmp_path, sizeof (tmp_path), "%s.%d", path, (int) getpid ());
+    f = fopen (tmp_path, "wb");
+    if (f != NULL) {
+      written = (fwrite (binary, 1, size, f) == size);
+      if ((fclose (f) == 0) && written)
+        rename (tmp_path, path);
+      else
+        remove (tmp_path);
+    }
+  }
+  free (binary);
+}
+
+static cl_program buildProgram( const char *kernel_source, const char *options)
+{
+  cl_program prog = NULL;
+  cl_int err = CL_SUCCESS;
+  char path[1024];
+  bool cached;
+
+  cached = cachePath (kernel_source, options, path, sizeof (path));
+  if (cached) {
+    prog = loadProgramBinary (path);
+    if (prog != NULL) {
+      if (CL_SUCCESS == clBuildProgram (prog, 0, NULL, options, NULL, NULL))
+        return prog;
+      /* Stale or foreign binary: fall back to the source.  */
+      clReleaseProgram (prog);
+    }
+  }
+
+  /* Create the compute program from the source buffer.  */
+  prog = clCreateProgramWithSource (context, 1,
+                                    (const char **) &kernel_source,
+                                    NULL, &err);
+  if (!prog || err != CL_SUCCESS) {
+    die ("Error: Failed to create compute program!");
+    return NULL;
+  }
+
+  /* Build the program executable.  */
+  err = clBuildProgram (prog, 0, NULL, options, NULL, NULL);
+  if (err != CL_SUCCESS)
+    {
+      size_t len;
+      char buffer[2048];
+
+      clGetProgramBuildInfo (prog, device_id, CL_PROGRAM_BUILD_LOG,
+                             sizeof (buffer), buffer, &len);
+      die ("Error: Failed to build program executable!\n%s", buffer);
+      clReleaseProgram (prog);
+      return NULL;
+    }
+
+  if (cached)
+    storeProgramBinary (prog, path);
+
+  return prog;
+}
+
+cl_kernel createKernel( const char *kernel_source, char *kernel_name)
+{
+  cl_kernel kernel = NULL;
+  cl_int err = CL_SUCCESS;
+
+  /* Only build if the source differs from the one of the current program.  */
+  if ((program == NULL) || (program_source == NULL)
+       || (strcmp (program_source, kernel_source) != 0)) {
+    if (program != NULL)
+      clReleaseProgram (program);
+    free (program_source);
+    program = buildProgram (kernel_source, NULL);
+    program_source = (program == NULL) ? NULL : strdup (kernel_source);
+  }
+  if (program == NULL)
+    return NULL;
+
+  /* Create the compute kernel in the program.  */
+  kernel = clCreateKernel (program, kernel_name, &err);
+  if (!kernel || err != CL_SUCCESS) {
+    die ("Error: Failed to create compute kernel!");
+    kernel = NULL;
+  }
+  return kernel;
+}
+
+kernel_struct setupKernel( const char *kernel_source, char *kernel_name, int num_args, ...)
+{
+   kernel_struct kernels;
+   kernels.kernel1 = NULL;
+   kernels.kernel2 = NULL;
+   cl_int err1 = CL_SUCCESS;
+   cl_int err2 = CL_SUCCESS;
+   va_list ap;
+   int i;
+
+   kernels.kernel1 = createKernel( kernel_source, kernel_name);
+   kernels.kernel2 = createKernel( kernel_source, kernel_name);
+   releaseKernelArgs();
+   num_kernel_args = num_args;
+   num_runs = 0;
+   va_start(ap, num_args);
+   for(i=0; (i<num_args) && (kernels.kernel1 != NULL) && (kernels.kernel2 != NULL); i++) {
+      kernel_args[i].arg_t = va_arg(ap, clarg_type);
+      kernel_args[i].policy = TransferAlways;
+      kernel_args[i].every = 1;
+      switch( kernel_args[i].arg_t) {
+        case DoubleArr:
+          kernel_args[i].num_elems = va_arg(ap, int);
+          kernel_args[i].dhost_buf = va_arg(ap, double *);
+          kernel_args[i].dev_buf = allocDev(sizeof(double) * kernel_args[i].num_elems);
+          host2devDoubleArr ( kernel_args[i].dhost_buf, kernel_args[i].dev_buf, kernel_args[i].num_elems);
+          err1 = clSetKernelArg (kernels.kernel1, i, sizeof (cl_mem), &kernel_args[i].dev_buf);
+          if (i == 0)
+              err2 = clSetKernelArg(kernels.kernel2, i + 1, sizeof(cl_mem), &kernel_args[i].dev_buf);
+          else
+              err2 = clSetKernelArg(kernels.kernel2, i - 1, sizeof(cl_mem), &kernel_args[i].dev_buf);
+          if( CL_SUCCESS != err1) {
+            die ("Error: Failed to set kernel arg %d!", i);
+            kernels.kernel1 = NULL;
+          }
+          if (CL_SUCCESS != err2) {
+              die("Error: Failed to set kernel arg %d!", i);
+              kernels.kernel2 = NULL;
+          }
+          break;
+        case FloatArr:
+          kernel_args[i].num_elems = va_arg(ap, int);
+          kernel_args[i].host_buf = va_arg(ap, float *);
+          kernel_args[i].dev_buf = allocDev ( sizeof (float) * kernel_args[i].num_elems);
+          host2devFloatArr ( kernel_args[i].host_buf, kernel_args[i].dev_buf, kernel_args[i].num_elems);
+          err1 = clSetKernelArg (kernels.kernel1, i, sizeof (cl_mem), &kernel_args[i].dev_buf);
+          if (i == 0)
+              err2 = clSetKernelArg(kernels.kernel2, i + 1, sizeof(cl_mem), &kernel_args[i].dev_buf);
+          else
+              err2 = clSetKernelArg(kernels.kernel2, i - 1, sizeof(cl_mem), &kernel_args[i].dev_buf);
+          if( CL_SUCCESS != err1) {
+            die ("Error: Failed to set kernel arg %d!", i);
+            kernels.kernel1= NULL;
+          }
+          if (CL_SUCCESS != err2) {
+              die("Error: Failed to set kernel arg %d!", i);
+              kernels.kernel2 = NULL;
+          }
+          break;
+        case BoolArr:
+          kernel_args[i].num_elems = va_arg(ap, int);
+          kernel_args[i].bhost_buf = va_arg(ap, bool *);
+          kernel_args[i].dev_buf = allocDev ( sizeof (bool) * kernel_args[i].num_elems);
+          host2devBoolArr ( kernel_args[i].bhost_buf, kernel_args[i].dev_buf, kernel_args[i].num_elems);
+          err1 = clSetKernelArg (kernels.kernel1, i, sizeof (cl_mem), &kernel_args[i].dev_buf);
+          err2 = clSetKernelArg (kernels.kernel2, i, sizeof (cl_mem), &kernel_args[i].dev_buf);
+          if( CL_SUCCESS != err1) {
+            die ("Error: Failed to set kernel arg %d!", i);
+            kernels.kernel1= NULL;
+          }
+          if (CL_SUCCESS != err2) {
+              die("Error: Failed to set kernel arg %d!", i);
+              kernels.kernel2 = NULL;
+          }
+          break;
+        case DoubleConst:
+          kernel_args[i].eps = va_arg(ap, double);
+          err1 = clSetKernelArg (kernels.kernel1, i, sizeof (double), &kernel_args[i].eps);
+          err2 = clSetKernelArg (kernels.kernel2, i, sizeof (double), &kernel_args[i].eps);
+          if( CL_SUCCESS != err1) {
+            die ("Error: Failed to set kernel arg %d!", i);
+            kernels.kernel1 = NULL;
+          }
+          if (CL_SUCCESS != err2) {
+              die("Error: Failed to set kernel arg %d!", i);
+              kernels.kernel2 = NULL;
+          }
+          break;
+        case IntConst:
+          kernel_args[i].val = va_arg(ap, unsigned int);
+          err1 = clSetKernelArg (kernels.kernel1, i, sizeof (unsigned int), &kernel_args[i].val);
+          err2 = clSetKernelArg (kernels.kernel2, i, sizeof (unsigned int), &kernel_args[i].val);
+          if( CL_SUCCESS != err1) {
+            die ("Error: Failed to set kernel arg %d!", i);
+            kernels.kernel1 = NULL;
+          }
+          if (CL_SUCCESS != err2) {
+              die("Error: Failed to set kernel arg %d!", i);
+              kernels.kernel2 = NULL;
+          }
+          break;
+        default:
+          die ("Error: illegal argument tag for executeKernel!");
+          kernels.kernel1 = NULL;
+          kernels.kernel2 = NULL;
+      }
+   }
+   va_end(ap);
+
+   return kernels;
+}
+
+cl_int launchKernel( cl_kernel kernel, int dim, size_t *global, size_t *local)
+{
+  cl_int err;
+  cl_event ev = NULL;
+
+  clock_gettime(1, &start);
+  if (CL_SUCCESS
+      != clEnqueueNDRangeKernel (commands, kernel,
+                                 dim, NULL, global, local, 0, NULL, PROF_EVENT (ev)))
+    die ("Error: Failed to execute kernel!");
+
+  /* Wait for all commands to complete.  */
+  err = clFinish (commands);
+  clock_gettime(1, &stop);
+  kernel_time += (stop.tv_sec -start.tv_sec)*1000.0
+                  + (stop.tv_nsec -start.tv_nsec)/1000000.0;
+  profRecord (ev, ProfKernel);
+
+  return err;
+}
+
+cl_int enqueueKernel( cl_kernel kernel, int dim, size_t *global, size_t *local)
+{
+  cl_int err;
+  cl_event ev = NULL;
+
+  if (!kernels_pending) {
+    clock_gettime(1, &start);
+    kernels_pending = true;
+  }
+
+  err = clEnqueueNDRangeKernel (commands, kernel,
+                                dim, NULL, global, local, 0, NULL, PROF_EVENT (ev));
+  if (CL_SUCCESS != err)
+    die ("Error: Failed to enqueue kernel!");
+  profRecord (ev, ProfKernel);
+
+  return err;
+}
+
+cl_int finishKernels()
+{
+  cl_int err;
+
+  /* Wait for all commands to complete.  */
+  err = clFinish (commands);
+  if (kernels_pending) {
+    clock_gettime(1, &stop);
+    kernel_time += (stop.tv_sec -start.tv_sec)*1000.0
+                    + (stop.tv_nsec -start.tv_nsec)/1000000.0;
+    kernels_pending = false;
+  }
+
+  return err;
+}
+
+static void dev2hostArg( int i)
+{
+  if( kernel_args[i].arg_t == DoubleArr) {
+    dev2hostDoubleArr ( kernel_args[i].dev_buf, kernel_args[i].dhost_buf, kernel_args[i].num_elems);
+  } else if( kernel_args[i].arg_t == FloatArr) {
+    dev2hostFloatArr ( kernel_args[i].dev_buf, kernel_args[i].host_buf, kernel_args[i].num_elems);
+  } else if( kernel_args[i].arg_t == BoolArr) {
+    dev2hostBoolArr ( kernel_args[i].dev_buf, kernel_args[i].bhost_buf, kernel_args[i].num_elems);
+  }
+}
+
+cl_int runKernel( cl_kernel kernel, int dim, size_t *global, size_t *local)
+{
+  cl_int err = CL_SUCCESS;
+
+  launchKernel( kernel, dim, global, local);
+
+  for( int i=0; i< num_kernel_args; i++) {
+    dev2hostArg( i);
+  }
+
+  return err;
+}
+
+void setTransferPolicy( int arg, transfer_policy policy, int k)
+{
+  if( arg < 0 || arg >= num_kernel_args) {
+    die ("Error: setTransferPolicy called with illegal argument %d!", arg);
+  } else if( (policy == TransferEveryK) && (k < 1)) {
+    die ("Error: setTransferPolicy needs k >= 1 for TransferEveryK!");
+  } else {
+    kernel_args[arg].policy = policy;
+    kernel_args[arg].every = (policy == TransferEveryK) ? k : 1;
+  }
+}
+
+cl_int runKernelSelective( cl_kernel kernel, int dim, size_t *global, size_t *local)
+{
+  cl_int err;
+
+  err = launchKernel( kernel, dim, global, local);
+  num_runs++;
+
+  for( int i=0; i< num_kernel_args; i++) {
+    if( (kernel_args[i].policy == TransferAlways)
+         || ((kernel_args[i].policy == TransferEveryK)
+             && (num_runs % kernel_args[i].every == 0)))
+      dev2hostArg( i);
+  }
+
+  return err;
+}
+
+void fetchArg( int arg)
+{
+  if( arg < 0 || arg >= num_kernel_args) {
+    die ("Error: fetchArg called with illegal argument %d!", arg);
+  } else {
+    dev2hostArg( arg);
+  }
+}
+
+void fetchFinal()
+{
+  for( int i=0; i< num_kernel_args; i++) {
+    if( (kernel_args[i].policy == TransferAtEnd)
+         || (kernel_args[i].policy == TransferEveryK))
+      dev2hostArg( i);
+  }
+}
+
+void releaseKernelArgs()
+{
+  for( int i=0; i< num_kernel_args; i++) {
+    if( (kernel_args[i].arg_t == FloatArr)
+         || (kernel_args[i].arg_t == DoubleArr)
+         || (kernel_args[i].arg_t == BoolArr))
+      releaseDev (kernel_args[i].dev_buf);
+  }
+  num_kernel_args = 0;
+}
+
+void printKernelTime()
+{
+  int min, sec;
+  double msec;
+
+  min = (int)kernel_time/60000;
+  sec = (int)(kernel_time - (min*60000)) / 1000;
+  msec = kernel_time - (min*60000) - (sec*1000);
+
+  if (kernel_time > 60000) {
+    printf( "total time spent in kernel executions: %d min %d sec %f msec\n", min, sec, msec);
+  } else if (kernel_time >1000) {
+    printf( "total time spent in kernel executions: %d sec %f msec\n", sec, msec);
+  } else {
+    printf( "total time spent in kernel executions: %f msec\n", msec);
+  }
+
+  if (pool_requests > 0) {
+    printf( "device buffers: %ld requests, %ld from the pool (%.1f%%), peak %.1f MB\n",
+            pool_requests, pool_hits, 100.0 * pool_hits / pool_requests,
+            peak_bytes / (1024.0 * 1024.0));
+  }
+
+  if (profiling) {
+    profFlush ();
+    printf( "profiled commands (total msec: queued->submit / submit->start / start->end):\n");
+    for (int t = 0; t < PROF_TYPES; t++) {
+      if (prof_sums[t].count > 0) {
+        printf( "  %-6s x %6ld: %12f / %12f / %12f  (avg run %f)\n", prof_names[t],
+                prof_sums[t].count, prof_sums[t].queued, prof_sums[t].submit,
+                prof_sums[t].run, prof_sums[t].run / prof_sums[t].count);
+      }
+    }
+  }
+}
+
+cl_int freeDevice()
+{
+  cl_int err;
+
+  profFlush ();
+  releaseKernelArgs ();
+  drainPool ();
+  err = clReleaseProgram (program);
+  program = NULL;
+  free (program_source);
+  program_source = NULL;
+  err = clReleaseCommandQueue (commands);
+  err = clReleaseContext (context);
+
+  return err;
+}
+
+void clPrintDevInfo() {
+   char device_string[1024];
+   clGetDeviceInfo(device_id, CL_DEVICE_NAME, sizeof(device_string), &device_string, NULL);
+   printf("\nCL_DEVICE_NAME: \t\t\t%s\n", device_string);
+   
+   size_t workgroup_size;
+   clGetDeviceInfo(device_id, CL_DEVICE_MAX_WORK_GROUP_SIZE, sizeof(workgroup_size), &workgroup_size, NULL);
+   printf("CL_DEVICE_MAX_WORK_GROUP_SIZE: \t\t%lu\n", workgroup_size);
+   
+   size_t workitem_size[3];
+   clGetDeviceInfo(device_id, CL_DEVICE_MAX_WORK_ITEM_SIZES, sizeof(workitem_size), &workitem_size, NULL);
+   printf("CL_DEVICE_MAX_WORK_ITEM_SIZES\t\t%lu / %lu / %lu\n\n", workitem_size[0], workitem_size[1], workitem_size[2]);
+}
+
+
+
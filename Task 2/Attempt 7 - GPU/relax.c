@@ -0,0 +1,205 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <math.h>
+#include <time.h>
+#include <CL/cl.h>
+#include "simple.h"
+
+#define N 10000000   // length of the vectors
+#define EPS 0.1      // convergence criterium
+#define HEAT 100.0   // heat value on the boundary
+
+struct timespec start, stop;
+
+void printTimeElapsed(char *text)
+{
+  double elapsed = (stop.tv_sec -start.tv_sec)*1000.0
+                  + (double)(stop.tv_nsec -start.tv_nsec)/1000000.0;
+  printf( "%s: %f msec\n", text, elapsed);
+}
+
+//
+// allocate a vector of length "n"
+//
+double *allocVector(int n)
+{
+   double *v;
+   v = (double *)malloc( n*sizeof(double));
+   return v;
+}
+
+//
+// allocate a bool vector of length "n"
+//
+bool *allocStable(int n)
+{
+   bool *s;
+   s = (bool *)malloc( n*sizeof(bool));
+   return s;
+}
+
+//
+// initialise the values of the given vector "out" of length "n"
+//
+void init(double *out, int n)
+{
+   int i;
+
+   for(i=1; i<n; i++) {
+      out[i] = 0;
+   }
+   out[0] = HEAT;
+}
+
+//
+// initialise the values of the given vector "out" of length "n"
+//
+void binit(bool *out, int n)
+{
+   int i;
+
+   for(i=0; i<n; i++) {
+      out[i] = false;
+   }
+}
+
+//
+// print the values of a given vector "out" of length "n"
+//
+void print(double *out, int n)
+{
+   int i;
+
+   printf("<");
+   for(i=0; i<n; i++) {
+      printf(" %f", out[i]);
+   }
+   printf(">\n");
+}
+
+//
+// optimal over-relaxation factor for the relax problem of length "n":
+// the Jacobi iteration matrix for the steady state has spectral radius
+// rho = cos(pi/(n-1)), which gives omega = 2 / (1 + sqrt(1 - rho^2))
+//
+double optimalOmega(int n)
+{
+   return 2.0 / (1.0 + sin(M_PI / (n - 1)));
+}
+
+//
+//relax function in kernel source: one half sweep of red-black SOR in
+//place, updating the points of one color (parity of the index) only.
+//Both half sweeps only ever clear the stability flag; the host sets it
+//before the red one.
+//
+const char *KernelSource =                                       "\n"
+  "__kernel void relax(                                          \n"
+  "   __global double* u,                                        \n"
+  "   __global bool* stable,                                     \n"
+  "   const double eps,                                          \n"
+  "   const double omega,                                        \n"
+  "   const unsigned int color,                                  \n"
+  "   const unsigned int count)                                  \n"
+  "{                                                             \n"
+  "   int i = 2*get_global_id(0) + color;                        \n"
+  "   int n = count;                                             \n"
+  "   double old, gs;                                            \n"
+  "   if (i > 0 && i < n-1) {                                    \n"
+  "      old = u[i];                                             \n"
+  "      gs = 0.5*(u[i-1] + u[i+1]);                             \n"
+  "      u[i] = old + omega*(gs - old);                          \n"
+  "      if (fabs(u[i] - old) > eps)                             \n"
+  "         stable[0] = false;                                   \n"
+  "   }                                                          \n"
+  "}                                                             \n"
+  "\n";
+
+int main()
+{
+   cl_int err;
+   cl_kernel kernel;
+   cl_mem u, flag;
+   size_t global[1];
+   size_t local[1];
+  
+   double *a;
+   bool *stable;
+   bool yes = true;
+   double eps = EPS;
+   double omega;
+   unsigned int color, count;
+   int n;
+   int iterations = 0;
+
+   a = allocVector(N);
+   stable = allocStable(1);
+
+   init(a, N);
+   binit(stable, 1);
+
+   n = N;
+   count = n;
+   omega = optimalOmega(n);
+   
+   local[0] = 32;
+   printf("work group size: %d\n", (int)local[0]);
+   global[0] = (((n + 1) / 2 + local[0] - 1) / local[0]) * local[0];
+   printf("global work size: %d\n", (int)global[0]);
+   printf("omega: %f\n\n", omega);
+
+   printf("size   : %d M (%d MB)\n", n/1000000, (int)(n*sizeof(double) / (1024*1024)));
+   printf("heat   : %f\n", HEAT);
+   printf("epsilon: %f\n", EPS);
+   
+   err = initGPU();
+   //clPrintDevInfo();
+      
+   if (err == CL_SUCCESS) {
+      clock_gettime(1, &start);
+      // the vector is updated in place, so a single kernel does both colors
+      // and its buffers are bound once; only the color changes
+      kernel = createKernel(KernelSource, "relax");
+      u = allocDev(sizeof(double) * n);
+      flag = allocDev(sizeof(bool));
+      host2devDoubleArr(a, u, n);
+      color = 0;
+      if (kernel == NULL
+          || clSetKernelArg(kernel, 0, sizeof(cl_mem), &u) != CL_SUCCESS
+          || clSetKernelArg(kernel, 1, sizeof(cl_mem), &flag) != CL_SUCCESS
+          || clSetKernelArg(kernel, 2, sizeof(double), &eps) != CL_SUCCESS
+          || clSetKernelArg(kernel, 3, sizeof(double), &omega) != CL_SUCCESS
+          || clSetKernelArg(kernel, 4, sizeof(unsigned int), &color) != CL_SUCCESS
+          || clSetKernelArg(kernel, 5, sizeof(unsigned int), &count) != CL_SUCCESS) {
+         printf("cannot set up the relax kernel\n");
+         return 1;
+      }
+
+      do {         
+         host2devBoolArr(&yes, flag, 1);
+         for (color = 0; color < 2; color++) {
+            clSetKernelArg(kernel, 4, sizeof(unsigned int), &color);
+            launchKernel(kernel, 1, global, local);
+         }
+         // the stability flag is complete after every black half sweep
+         dev2hostBoolArr(flag, stable, 1);
+         
+         iterations++;
+      } while(!stable[0]);
+      dev2hostDoubleArr(u, a, n);
+      
+      clock_gettime(1, &stop);
+      
+      printf("Number of iterations: %d\n", iterations);
+      printTimeElapsed("GPU time spent");
+      printKernelTime();
+      
+      releaseDev(u);
+      releaseDev(flag);
+      err = clReleaseKernel(kernel);
+      err = freeDevice();
+   }
+
+   return 0;
+}
@@ -0,0 +1,350 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <math.h>
+#include <time.h>
+#include <CL/cl.h>
+#include "simple.h"
+#include "tridiag.h"
+
+#define N 10000000   // length of the vectors
+#define EPS 0.1      // convergence criterium
+#define HEAT 100.0   // heat value on the boundary
+#define LOCAL 32     // work group size
+
+struct timespec start, stop;
+
+void printTimeElapsed(char *text)
+{
+  double elapsed = (stop.tv_sec -start.tv_sec)*1000.0
+                  + (double)(stop.tv_nsec -start.tv_nsec)/1000000.0;
+  printf( "%s: %f msec\n", text, elapsed);
+}
+
+//
+// allocate a vector of length "n"
+//
+double *allocVector(int n)
+{
+   double *v;
+   v = (double *)malloc( n*sizeof(double));
+   return v;
+}
+
+//
+// allocate a bool vector of length "n"
+//
+bool *allocStable(int n)
+{
+   bool *s;
+   s = (bool *)malloc( n*sizeof(bool));
+   return s;
+}
+
+//
+// initialise the values of the given vector "out" of length "n"
+//
+void init(double *out, int n)
+{
+   int i;
+
+   for(i=1; i<n; i++) {
+      out[i] = 0;
+   }
+   out[0] = HEAT;
+}
+
+//
+// initialise the values of the given vector "out" of length "n"
+//
+void binit(bool *out, int n)
+{
+   int i;
+
+   for(i=0; i<n; i++) {
+      out[i] = false;
+   }
+}
+
+//
+// print the values of a given vector "out" of length "n"
+//
+void print(double *out, int n)
+{
+   int i;
+
+   printf("<");
+   for(i=0; i<n; i++) {
+      printf(" %f", out[i]);
+   }
+   printf(">\n");
+}
+
+//
+// largest change a relax sweep would make to "u" of length "n", i.e. how far
+// "u" is from being a fixed point of the iteration the other attempts run
+//
+double relaxChange(double *u, int n)
+{
+   double change = 0.0;
+   double out;
+   int i;
+
+   for(i=1; i<n-1; i++) {
+      out = 0.25*u[i-1] + 0.5*u[i] + 0.25*u[i+1];
+      if (fabs(out - u[i]) > change)
+         change = fabs(out - u[i]);
+   }
+   return change;
+}
+
+//
+// largest deviation of "u" of length "n" from the exact steady state, the
+// straight line from u[0] = left to u[n-1] = right. The relax iterations
+// of the other attempts stop long before they reach it: at EPS 0.1 the
+// heat has spread over less than a hundred cells, so their results are no
+// reference for this one.
+//
+double steadyError(double *u, int n, double left, double right)
+{
+   double error = 0.0;
+   double exact;
+   int i;
+
+   for(i=0; i<n; i++) {
+      exact = left + (right - left) * ((double)i / (n-1));
+      if (fabs(u[i] - exact) > error)
+         error = fabs(u[i] - exact);
+   }
+   return error;
+}
+
+//
+// parallel cyclic reduction for the steady state of the relax stencil:
+//    u[0] = left, u[n-1] = right, -u[i-1] + 2u[i] - u[i+1] = 0 otherwise
+// - setup: the tridiagonal system (a, b, c) with right hand side d
+// - reduce: eliminates u[i-s] and u[i+s] from equation i using equations
+//   i-s and i+s; afterwards equation i couples to u[i-2s] and u[i+2s]
+//   only, and equations beyond either end read as u = 0
+// - solve: after ceil(log2(n)) reductions every equation has one unknown
+//
+const char *KernelSource =                                                     "\n"
+  "__kernel void setup(                                                        \n"
+  "   __global double* a,                                                      \n"
+  "   __global double* b,                                                      \n"
+  "   __global double* c,                                                      \n"
+  "   __global double* d,                                                      \n"
+  "   const double left,                                                       \n"
+  "   const double right,                                                      \n"
+  "   const unsigned int count)                                                \n"
+  "{                                                                           \n"
+  "   int i = get_global_id(0);                                                \n"
+  "   int n = count;                                                           \n"
+  "   bool inner = (i > 0) && (i < n-1);                                       \n"
+  "   if (i >= n)                                                              \n"
+  "      return;                                                               \n"
+  "   a[i] = inner ? -1.0 : 0.0;                                               \n"
+  "   b[i] = inner ? 2.0 : 1.0;                                                \n"
+  "   c[i] = inner ? -1.0 : 0.0;                                               \n"
+  "   d[i] = inner ? 0.0 : ((i == 0) ? left : right);                          \n"
+  "}                                                                           \n"
+  "                                                                            \n"
+  "__kernel void reduce(                                                       \n"
+  "   __global double* a,                                                      \n"
+  "   __global double* b,                                                      \n"
+  "   __global double* c,                                                      \n"
+  "   __global double* d,                                                      \n"
+  "   __global double* a2,                                                     \n"
+  "   __global double* b2,                                                     \n"
+  "   __global double* c2,                                                     \n"
+  "   __global double* d2,                                                     \n"
+  "   const unsigned int stride,                                               \n"
+  "   const unsigned int count)                                                \n"
+  "{                                                                           \n"
+  "   int i = get_global_id(0);                                                \n"
+  "   int n = count;                                                           \n"
+  "   int s = stride;                                                          \n"
+  "   bool lo = (i - s >= 0);                                                  \n"
+  "   bool hi = (i + s < n);                                                   \n"
+  "   double k1, k2;                                                           \n"
+  "   if (i >= n)                                                              \n"
+  "      return;                                                               \n"
+  "   k1 = lo ? a[i] / b[i-s] : 0.0;                                           \n"
+  "   k2 = hi ? c[i] / b[i+s] : 0.0;                                           \n"
+  "   a2[i] = lo ? -a[i-s] * k1 : 0.0;                                         \n"
+  "   c2[i] = hi ? -c[i+s] * k2 : 0.0;                                         \n"
+  "   b2[i] = b[i] - (lo ? c[i-s] * k1 : 0.0) - (hi ? a[i+s] * k2 : 0.0);      \n"
+  "   d2[i] = d[i] - (lo ? d[i-s] * k1 : 0.0) - (hi ? d[i+s] * k2 : 0.0);      \n"
+  "}                                                                           \n"
+  "                                                                            \n"
+  "__kernel void solve(                                                        \n"
+  "   __global double* b,                                                      \n"
+  "   __global double* d,                                                      \n"
+  "   __global double* u,                                                      \n"
+  "   const unsigned int count)                                                \n"
+  "{                                                                           \n"
+  "   int i = get_global_id(0);                                                \n"
+  "   int n = count;                                                           \n"
+  "   if (i < n)                                                               \n"
+  "      u[i] = d[i] / b[i];                                                   \n"
+  "}                                                                           \n"
+  "\n";
+
+//
+// set argument "i" of kernel "k", unless "*err" holds a failure already
+//
+void setArg(cl_int *err, cl_kernel k, cl_uint i, size_t size, const void *value)
+{
+   if (*err != CL_SUCCESS)
+      return;
+   *err = clSetKernelArg(k, i, size, value);
+   if (*err != CL_SUCCESS)
+      fprintf(stderr, "Error: Failed to set kernel arg %d!\n", i);
+}
+
+//
+// launch "k", unless "*err" holds a failure already
+//
+void launch(cl_int *err, cl_kernel k, size_t *global, size_t *local)
+{
+   if (*err != CL_SUCCESS)
+      return;
+   *err = launchKernel(k, 1, global, local);
+}
+
+//
+// solve the system on the device; returns the number of reduction steps,
+// or -1 if a kernel, a buffer or a launch failed and "u" holds no solution
+//
+int solveTridiagCL(double *u, int n, double left, double right)
+{
+   cl_kernel setup, reduce, solve;
+   cl_mem sys[2][4];
+   cl_mem out;
+   cl_int err = CL_SUCCESS;
+   size_t global[1];
+   size_t local[1];
+   unsigned int count = n;
+   unsigned int stride;
+   int steps = 0;
+   int k, j;
+
+   local[0] = LOCAL;
+   global[0] = ((n + LOCAL - 1) / LOCAL) * LOCAL;
+
+   setup = createKernel(KernelSource, "setup");
+   reduce = createKernel(KernelSource, "reduce");
+   solve = createKernel(KernelSource, "solve");
+   if (setup == NULL || reduce == NULL || solve == NULL)
+      err = CL_INVALID_KERNEL;
+   for (k = 0; k < 2; k++)
+      for (j = 0; j < 4; j++) {
+         sys[k][j] = allocDev(sizeof(double) * n);
+         if (sys[k][j] == NULL)
+            err = CL_MEM_OBJECT_ALLOCATION_FAILURE;
+      }
+   out = allocDev(sizeof(double) * n);
+   if (out == NULL)
+      err = CL_MEM_OBJECT_ALLOCATION_FAILURE;
+
+   for (j = 0; j < 4; j++)
+      setArg(&err, setup, j, sizeof(cl_mem), &sys[0][j]);
+   setArg(&err, setup, 4, sizeof(double), &left);
+   setArg(&err, setup, 5, sizeof(double), &right);
+   setArg(&err, setup, 6, sizeof(unsigned int), &count);
+   launch(&err, setup, global, local);
+
+   setArg(&err, reduce, 9, sizeof(unsigned int), &count);
+   for (stride = 1; stride < count; stride *= 2, steps++) {
+      for (j = 0; j < 4; j++) {
+         setArg(&err, reduce, j, sizeof(cl_mem), &sys[steps % 2][j]);
+         setArg(&err, reduce, 4 + j, sizeof(cl_mem), &sys[(steps + 1) % 2][j]);
+      }
+      setArg(&err, reduce, 8, sizeof(unsigned int), &stride);
+      launch(&err, reduce, global, local);
+   }
+
+   setArg(&err, solve, 0, sizeof(cl_mem), &sys[steps % 2][1]);
+   setArg(&err, solve, 1, sizeof(cl_mem), &sys[steps % 2][3]);
+   setArg(&err, solve, 2, sizeof(cl_mem), &out);
+   setArg(&err, solve, 3, sizeof(unsigned int), &count);
+   launch(&err, solve, global, local);
+   if (err == CL_SUCCESS)
+      dev2hostDoubleArr(out, u, n);
+
+   for (k = 0; k < 2; k++)
+      for (j = 0; j < 4; j++)
+         releaseDev(sys[k][j]);
+   releaseDev(out);
+   if (setup != NULL)
+      clReleaseKernel(setup);
+   if (reduce != NULL)
+      clReleaseKernel(reduce);
+   if (solve != NULL)
+      clReleaseKernel(solve);
+
+   return (err == CL_SUCCESS) ? steps : -1;
+}
+
+int main()
+{
+   cl_int err;
+  
+   double *a;
+   double left, right;
+   int n;
+   int steps;
+
+   a = allocVector(N);
+
+   init(a, N);
+
+   n = N;
+   left = a[0];
+   right = a[n-1];
+   
+   printf("work group size: %d\n", LOCAL);
+   printf("global work size: %d\n\n", n);
+
+   printf("size   : %d M (%d MB)\n", n/1000000, (int)(n*sizeof(double) / (1024*1024)));
+   printf("heat   : %f\n", HEAT);
+   printf("epsilon: %f\n", EPS);
+   
+   err = initGPU();
+   //clPrintDevInfo();
+      
+   steps = -1;
+   if (err == CL_SUCCESS) {
+      clock_gettime(1, &start);
+      steps = solveTridiagCL(a, n, left, right);
+      clock_gettime(1, &stop);
+      
+      if (steps >= 0) {
+         printf("Number of reduction steps: %d\n", steps);
+         printTimeElapsed("GPU time spent");
+         printKernelTime();
+      } else {
+         printf("cannot solve on the device, solving on the host\n");
+      }
+      
+      err = freeDevice();
+   } else {
+      printf("no OpenCL device, solving on the host\n");
+   }
+   if (steps < 0) {
+      clock_gettime(1, &start);
+      steps = solveTridiagNative(a, n, left, right);
+      clock_gettime(1, &stop);
+      if (steps < 0) {
+         printf("cannot solve on the host\n");
+         return 1;
+      }
+
+      printf("Number of reduction steps: %d\n", steps);
+      printTimeElapsed("CPU time spent");
+   }
+   printf("largest change by a relax sweep: %e (epsilon %f)\n", relaxChange(a, n), EPS);
+   printf("largest error to the steady state: %e\n", steadyError(a, n, left, right));
+
+   return 0;
+}
@@ -0,0 +1,142 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "tridiag.h"
+
+#define THREADS_ENV "HEAT_THREADS"
+#define MAX_THREADS 256
+
+#define die(msg, ...) do {                      \
+  (void) fprintf (stderr, msg, ## __VA_ARGS__); \
+  (void) fprintf (stderr, "\n");                \
+} while (0)
+
+/* One tridiagonal system: a (sub), b (diagonal), c (super), d (rhs).  */
+typedef struct {
+  double *a, *b, *c, *d;
+} system_t;
+
+typedef struct {
+  int       id;
+  int       threads;
+  int       n;
+  int       steps;
+  system_t  sys[2];           /* Ping-pong between reduction steps.  */
+  double   *u;
+  pthread_barrier_t *barrier;
+} thread_arg;
+
+static void *pcrThread( void *p)
+{
+  thread_arg *arg = (thread_arg *) p;
+  long n = arg->n;
+  long lo = n * arg->id / arg->threads;
+  long hi = n * (arg->id + 1) / arg->threads;
+  system_t *in, *out;
+  double k1, k2;
+  long s = 1;
+
+  for (int step = 0; step < arg->steps; step++, s *= 2) {
+    in = &arg->sys[step % 2];
+    out = &arg->sys[(step + 1) % 2];
+    for (long i = lo; i < hi; i++) {
+      /* Equations beyond either end read as u = 0.  */
+      k1 = (i - s >= 0) ? in->a[i] / in->b[i-s] : 0.0;
+      k2 = (i + s < n) ? in->c[i] / in->b[i+s] : 0.0;
+      out->a[i] = (i - s >= 0) ? -in->a[i-s] * k1 : 0.0;
+      out->c[i] = (i + s < n) ? -in->c[i+s] * k2 : 0.0;
+      out->b[i] = in->b[i]
+                  - ((i - s >= 0) ? in->c[i-s] * k1 : 0.0)
+                  - ((i + s < n) ? in->a[i+s] * k2 : 0.0);
+      out->d[i] = in->d[i]
+                  - ((i - s >= 0) ? in->d[i-s] * k1 : 0.0)
+                  - ((i + s < n) ? in->d[i+s] * k2 : 0.0);
+    }
+    pthread_barrier_wait (arg->barrier);
+  }
+
+  in = &arg->sys[arg->steps % 2];
+  for (long i = lo; i < hi; i++)
+    arg->u[i] = in->d[i] / in->b[i];
+  return NULL;
+}
+
+static void freeSystems( system_t *sys)
+{
+  for (int k = 0; k < 2; k++) {
+    free (sys[k].a);
+    free (sys[k].b);
+    free (sys[k].c);
+    free (sys[k].d);
+  }
+}
+
+int solveTridiagNative( double *u, int n, double left, double right)
+{
+  thread_arg args[MAX_THREADS];
+  pthread_t threads[MAX_THREADS];
+  pthread_barrier_t barrier;
+  system_t sys[2];
+  const char *env;
+  long cpus;
+  int num_threads, steps;
+
+  cpus = sysconf (_SC_NPROCESSORS_ONLN);
+  num_threads = (cpus > 0) ? (int) cpus : 1;
+  env = getenv (THREADS_ENV);
+  if (env != NULL && atoi (env) > 0)
+    num_threads = atoi (env);
+  if (num_threads > MAX_THREADS)
+    num_threads = MAX_THREADS;
+  if (num_threads > n)
+    num_threads = n;
+
+  for (steps = 0; (1L << steps) < n; steps++)
+    ;
+
+  for (int k = 0; k < 2; k++) {
+    sys[k].a = (double *) malloc (n * sizeof (double));
+    sys[k].b = (double *) malloc (n * sizeof (double));
+    sys[k].c = (double *) malloc (n * sizeof (double));
+    sys[k].d = (double *) malloc (n * sizeof (double));
+  }
+  for (int k = 0; k < 2; k++) {
+    if (!sys[k].a || !sys[k].b || !sys[k].c || !sys[k].d) {
+      die ("Error: Failed to allocate the tridiagonal system!");
+      freeSystems (sys);
+      return -1;
+    }
+  }
+  for (int i = 0; i < n; i++) {
+    int inner = (i > 0) && (i < n-1);
+    sys[0].a[i] = inner ? -1.0 : 0.0;
+    sys[0].b[i] = inner ? 2.0 : 1.0;
+    sys[0].c[i] = inner ? -1.0 : 0.0;
+    sys[0].d[i] = inner ? 0.0 : ((i == 0) ? left : right);
+  }
+
+  pthread_barrier_init (&barrier, NULL, num_threads);
+  for (int t = 0; t < num_threads; t++) {
+    args[t].id = t;
+    args[t].threads = num_threads;
+    args[t].n = n;
+    args[t].steps = steps;
+    args[t].sys[0] = sys[0];
+    args[t].sys[1] = sys[1];
+    args[t].u = u;
+    args[t].barrier = &barrier;
+    if (t > 0 && pthread_create (&threads[t], NULL, pcrThread, &args[t]) != 0) {
+      die ("Error: Failed to create thread %d!", t);
+      exit (1);
+    }
+  }
+  pcrThread (&args[0]);
+  for (int t = 1; t < num_threads; t++)
+    pthread_join (threads[t], NULL);
+  pthread_barrier_destroy (&barrier);
+
+  freeSystems (sys);
+  return steps;
+}
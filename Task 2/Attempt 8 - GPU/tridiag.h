@@ -0,0 +1,21 @@
+#ifndef TRIDIAG_H_
+#define TRIDIAG_H_
+
+/*******************************************************************************
+ *
+ * solveTridiagNative : computes the steady state of the relax stencil on the
+ *               host, i.e. the solution of
+ *                  u[0] = left,  u[n-1] = right,
+ *                  -u[i-1] + 2u[i] - u[i+1] = 0   for 0 < i < n-1,
+ *               by parallel cyclic reduction with pthreads: every step
+ *               decouples each equation from its neighbours at distance s
+ *               and doubles s, so after ceil(log2(n)) steps every equation
+ *               holds a single unknown. The number of threads is taken from
+ *               the environment variable HEAT_THREADS, by default one per
+ *               online CPU. The solution is written to "u" (length "n").
+ *               Returns the number of reduction steps, or -1 on failure.
+ *
+ ******************************************************************************/
+extern int solveTridiagNative( double *u, int n, double left, double right);
+
+#endif /* TRIDIAG_H_ */
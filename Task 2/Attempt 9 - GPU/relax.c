@@ -0,0 +1,216 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <math.h>
+#include <time.h>
+#include <CL/cl.h>
+#include "simple.h"
+
+#define N 10000000   // length of the vectors
+#define EPS 0.1      // convergence criterium
+#define HEAT 100.0   // heat value on the boundary
+
+struct timespec start, stop;
+
+void printTimeElapsed(char *text)
+{
+  double elapsed = (stop.tv_sec -start.tv_sec)*1000.0
+                  + (double)(stop.tv_nsec -start.tv_nsec)/1000000.0;
+  printf( "%s: %f msec\n", text, elapsed);
+}
+
+//
+// allocate a vector of length "n"
+//
+double *allocVector(int n)
+{
+   double *v;
+   v = (double *)malloc( n*sizeof(double));
+   return v;
+}
+
+//
+// allocate a bool vector of length "n"
+//
+bool *allocStable(int n)
+{
+   bool *s;
+   s = (bool *)malloc( n*sizeof(bool));
+   return s;
+}
+
+//
+// initialise the values of the given vector "out" of length "n"
+//
+void init(double *out, int n)
+{
+   int i;
+
+   for(i=1; i<n; i++) {
+      out[i] = 0;
+   }
+   out[0] = HEAT;
+}
+
+//
+// initialise the values of the given vector "out" of length "n"
+//
+void binit(bool *out, int n)
+{
+   int i;
+
+   for(i=0; i<n; i++) {
+      out[i] = false;
+   }
+}
+
+//
+// print the values of a given vector "out" of length "n"
+//
+void print(double *out, int n)
+{
+   int i;
+
+   printf("<");
+   for(i=0; i<n; i++) {
+      printf(" %f", out[i]);
+   }
+   printf(">\n");
+}
+
+//
+// spectral bounds of the relax sweep: on the interior of a vector of length
+// "n" it has the eigenvalues (1 + cos(k*pi/(n-1)))/2, k = 1..n-2, which lie
+// in [1 - rho, rho] for rho = cos^2(pi/(2(n-1))). The interval is symmetric
+// around 1/2, so the shifted sweep 2*relax(x) - x has its eigenvalues in
+// [-sigma, sigma] for the Chebyshev parameter sigma = 2*rho - 1.
+//
+double chebyshevSigma(int n)
+{
+   double c = cos(M_PI / (2.0 * (n - 1)));
+   return 2.0*c*c - 1.0;
+}
+
+//
+// weight of Chebyshev step "k" (k >= 1): 1, 1/(1 - sigma^2/2), and then
+// w(k) = 1/(1 - sigma^2 * w(k-1)/4); "w" is the weight of step k-1
+//
+double chebyshevWeight(int k, double w, double sigma)
+{
+   if (k == 1)
+      return 1.0;
+   if (k == 2)
+      return 1.0 / (1.0 - sigma*sigma/2.0);
+   return 1.0 / (1.0 - sigma*sigma*w/4.0);
+}
+
+//
+//relax function in kernel source: one Chebyshev step built on the shifted
+//sweep 2*relax(x) - x, whose spectrum [-sigma, sigma] the weights are made
+//for: x(k+1) = x(k-1) + w(k+1) * (2*relax(x(k)) - x(k) - x(k-1)). x(k+1)
+//overwrites x(k-1) in place, so kernel1 and kernel2 ping-pong as for Jacobi.
+//The stability check is the one of the relax sweep applied to x(k).
+//
+const char *KernelSource =                                       "\n"
+  "__kernel void relax(                                          \n"
+  "   __global double* in,                                       \n"
+  "   __global double* prev,                                     \n"
+  "   __global bool* stable,                                     \n"
+  "   const double eps,                                          \n"
+  "   const double weight,                                       \n"
+  "   const unsigned int count)                                  \n"
+  "{                                                             \n"
+  "   int i = get_global_id(0);                                  \n"
+  "   int n = get_global_size(0);                                \n"
+  "   double jacobi;                                             \n"
+  "   if (i > 0 && i < n-1) {                                    \n"
+  "      jacobi = 0.25*in[i-1] + 0.5*in[i] + 0.25*in[i+1];       \n"
+  "   } else {                                                   \n"
+  "      jacobi = in[i];                                         \n"
+  "   }                                                          \n"
+  "   if (fabs(in[i] - jacobi) > eps)                            \n"
+  "      stable[0] = false;                                      \n"
+  "   prev[i] = prev[i] + weight*(2.0*jacobi - in[i] - prev[i]); \n"
+  "}                                                             \n"
+  "\n";
+
+int main()
+{
+   cl_int err;
+   kernel_struct kernels;
+   cl_kernel kernel;
+   size_t global[1];
+   size_t local[1];
+  
+   double *a,*b;
+   bool *stable;
+   double sigma;
+   double weight = 1.0;
+   int n, count;
+   int iterations = 0;
+
+   a = allocVector(N);
+   b = allocVector(N);
+   stable = allocStable(1);
+
+   init(a, N);
+   init(b, N);
+   binit(stable, 1);
+
+   n = N;
+   count = 0;
+   sigma = chebyshevSigma(n);
+   
+   local[0] = 32;
+   printf("work group size: %d\n", (int)local[0]);
+   global[0] = n;
+   printf("global work size: %d\n", n);
+   printf("sigma: %.12f\n\n", sigma);
+
+   printf("size   : %d M (%d MB)\n", n/1000000, (int)(n*sizeof(double) / (1024*1024)));
+   printf("heat   : %f\n", HEAT);
+   printf("epsilon: %f\n", EPS);
+   
+   err = initGPU();
+   //clPrintDevInfo();
+      
+   if (err == CL_SUCCESS) {
+      clock_gettime(1, &start);
+      // x(0) is in both vectors, so the first step reads a and writes b
+      kernels = setupKernel(KernelSource, "relax", 6, DoubleArr, n, a, DoubleArr, n, b, BoolArr, 1, stable, DoubleConst, EPS, DoubleConst, weight, IntConst, n);
+      // only the stability flags are needed on the host while iterating
+      setTransferPolicy(0, TransferAtEnd, 0);
+      setTransferPolicy(1, TransferAtEnd, 0);
+
+      do {         
+         weight = chebyshevWeight(iterations + 1, weight, sigma);
+         // reset the flag here: the work items can only clear it
+         stable[0] = true;
+         pushArg(2);
+         if(count == 0) {
+            kernel = kernels.kernel1;
+            count++;
+         } else {
+            kernel = kernels.kernel2;
+            count--;
+         }
+         clSetKernelArg(kernel, 4, sizeof(double), &weight);
+         runKernelSelective(kernel, 1, global, local);
+         
+         iterations++;
+      } while(!stable[0]);
+      fetchFinal();
+      
+      clock_gettime(1, &stop);
+      
+      printf("Number of iterations: %d\n", iterations);
+      printTimeElapsed("GPU time spent");
+      printKernelTime();
+      
+      err = clReleaseKernel(kernels.kernel1);
+      err = clReleaseKernel(kernels.kernel2);
+      err = freeDevice();
+   }
+
+   return 0;
+}
@@ -26,7 +26,7 @@ void printTimeElapsed(char *text)
 double *allocVector(int n)
 {
    double *v;
-   v = (double *)malloc( n*sizeof(double));
+   v = (double *)allocHost( n*sizeof(double));
    return v;
 }
 
@@ -0,0 +1,299 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <math.h>
+#include <time.h>
+
+#include <CL/cl.h>
+#include "simple.h"
+#include "tune.h"
+
+#define N 10000000   // length of the vectors
+#define EPS 0.1      // convergence criterium
+#define HEAT 100.0   // heat value on the boundary
+#define VECS 4       // vectors per work item, unless tuned
+#define VW_MAX 8     // widest vector type used by the kernel
+#define LOCAL 32     // work group size, unless tuned
+#define TUNE_SWEEPS 10  // sweeps timed per tuning candidate
+
+struct timespec start, stop;
+
+void printTimeElapsed(char *text)
+{
+  double elapsed = (stop.tv_sec -start.tv_sec)*1000.0
+                  + (double)(stop.tv_nsec -start.tv_nsec)/1000000.0;
+  printf( "%s: %f msec\n", text, elapsed);
+}
+
+//
+// allocate a vector of length "n"
+//
+double *allocVector(int n)
+{
+   double *v;
+   v = (double *)allocHost( n*sizeof(double));
+   return v;
+}
+
+//
+// allocate a bool vector of length "n"
+//
+bool *allocStable(int n)
+{
+   bool *s;
+   s = (bool *)allocHost( n*sizeof(bool));
+   return s;
+}
+
+//
+// initialise the values of the given vector "out" of length "n"
+//
+void init(double *out, int n)
+{
+   int i;
+
+   for(i=1; i<n; i++) {
+      out[i] = 0;
+   }
+   out[0] = HEAT;
+}
+
+//
+// initialise the values of the given vector "out" of length "n"
+//
+void binit(bool *out, int n)
+{
+   int i;
+
+   for(i=0; i<n; i++) {
+      out[i] = false;
+   }
+}
+
+//
+// print the values of a given vector "out" of length "n"
+//
+void print(double *out, int n)
+{
+   int i;
+
+   printf("<");
+   for(i=0; i<n; i++) {
+      printf(" %f", out[i]);
+   }
+   printf(">\n");
+}
+
+//
+// vector width for the kernel: the preferred double vector width of the
+// device, rounded down to a power of two in [2, VW_MAX]
+//
+int vectorWidth()
+{
+   int pref = preferredVectorWidthDouble();
+   int vw = 2;
+
+   while (vw * 2 <= pref && vw * 2 <= VW_MAX)
+      vw *= 2;
+   return vw;
+}
+
+//
+// relax function in kernel source: every work item updates VECS vectors of
+// VW doubles each, VW being set through the build options. Vectors touching
+// the boundary or the end of the array, which need not be a multiple of the
+// vector width, fall back to scalar code.
+//
+const char *KernelSource =                                       "\n"
+  "#define CAT(a, b) a ## b                                      \n"
+  "#define XCAT(a, b) CAT(a, b)                                  \n"
+  "#define VEC XCAT(double, VW)                                  \n"
+  "#define VLOAD XCAT(vload, VW)                                 \n"
+  "#define VSTORE XCAT(vstore, VW)                               \n"
+  "                                                              \n"
+  "__kernel void relax(                                          \n"
+  "   __global double* in,                                       \n"
+  "   __global double* out,                                      \n"
+  "   __global bool* stable,                                     \n"
+  "   const double eps,                                          \n"
+  "   const unsigned int count)                                  \n"
+  "{                                                             \n"
+  "   int n = count;                                             \n"
+  "   int first = get_global_id(0) * VW * VECS;                  \n"
+  "   for (int j0 = first; j0 < first + VW * VECS && j0 < n; j0 += VW) {\n"
+  "      if (j0 > 0 && j0 + VW < n) {                            \n"
+  "         VEC l = VLOAD(0, in + j0 - 1);                       \n"
+  "         VEC m = VLOAD(0, in + j0);                           \n"
+  "         VEC r = VLOAD(0, in + j0 + 1);                       \n"
+  "         VEC o = 0.25*l + 0.5*m + 0.25*r;                     \n"
+  "         VSTORE(o, 0, out + j0);                              \n"
+  "         if (any(fabs(m - o) > eps))                          \n"
+  "            stable[0] = false;                                \n"
+  "      } else {                                                \n"
+  "         for (int j = j0; j < j0 + VW && j < n; j++) {        \n"
+  "            if (j == 0 || j == n-1) {                         \n"
+  "               out[j] = in[j];                                \n"
+  "            } else {                                          \n"
+  "               out[j] = 0.25*in[j-1] + 0.5*in[j] + 0.25*in[j+1];\n"
+  "               if (fabs(in[j] - out[j]) > eps)                \n"
+  "                  stable[0] = false;                          \n"
+  "            }                                                 \n"
+  "         }                                                    \n"
+  "      }                                                       \n"
+  "   }                                                          \n"
+  "}                                                             \n"
+  "\n";
+
+//
+// global work size for "n" elements: one work item per c.vecs vectors of
+// c.vw doubles, rounded up to a multiple of the work group size
+//
+size_t globalSize(tune_config c, int n)
+{
+   size_t items = (n + c.vw*c.vecs - 1) / (c.vw*c.vecs);
+   return ((items + c.local - 1) / c.local) * c.local;
+}
+
+//
+// set the build options for the vector width and vectors per item of "c"
+//
+void configure(tune_config c)
+{
+   char options[64];
+
+   snprintf(options, sizeof(options), "-D VW=%d -D VECS=%d", c.vw, c.vecs);
+   setBuildOptions(options);
+}
+
+//
+// host vectors the tuning benchmark runs on
+//
+typedef struct {
+   double *a;
+   double *b;
+   bool *stable;
+} bench_data;
+
+//
+// tuning benchmark: TUNE_SWEEPS sweeps over the vectors in "ctx" with
+// configuration "c"; with zero-copy buffers this changes the host vectors
+//
+double bench(tune_config c, void *ctx)
+{
+   bench_data *v = (bench_data *)ctx;
+   kernel_struct kernels;
+   size_t global[1];
+   size_t local[1];
+   double elapsed;
+   int i;
+
+   configure(c);
+   global[0] = globalSize(c, N);
+   local[0] = c.local;
+   kernels = setupKernel(KernelSource, "relax", 5, DoubleArr, N, v->a, DoubleArr, N, v->b, BoolArr, 1, v->stable, DoubleConst, EPS, IntConst, N);
+   if (kernels.kernel1 == NULL || kernels.kernel2 == NULL
+       || launchKernel(kernels.kernel1, 1, global, local) != CL_SUCCESS) {   // warm up
+      elapsed = -1.0;
+   } else {
+      clock_gettime(1, &start);
+      for (i = 0; i < TUNE_SWEEPS; i++)
+         launchKernel((i % 2 == 0) ? kernels.kernel2 : kernels.kernel1, 1, global, local);
+      clock_gettime(1, &stop);
+      elapsed = (stop.tv_sec -start.tv_sec)*1000.0
+                 + (double)(stop.tv_nsec -start.tv_nsec)/1000000.0;
+   }
+   if (kernels.kernel1 != NULL)
+      clReleaseKernel(kernels.kernel1);
+   if (kernels.kernel2 != NULL)
+      clReleaseKernel(kernels.kernel2);
+   releaseKernelArgs();
+   return elapsed;
+}
+
+int main()
+{
+   cl_int err;
+   kernel_struct kernels;
+   size_t global[1];
+   size_t local[1];
+  
+   double *a,*b;
+   bool *stable;
+   tune_config config, fallback;
+   bench_data bench_ctx;
+   int n, count;
+   int iterations = 0;
+
+   a = allocVector(N);
+   b = allocVector(N);
+   stable = allocStable(1);
+
+   init(a, N);
+   init(b, N);
+   binit(stable, 1);
+
+   n = N;
+   count = 0;
+
+   printf("size   : %d M (%d MB)\n", n/1000000, (int)(n*sizeof(double) / (1024*1024)));
+   printf("heat   : %f\n", HEAT);
+   printf("epsilon: %f\n", EPS);
+   
+   err = initCPU();
+   //clPrintDevInfo();
+      
+   if (err == CL_SUCCESS) {
+      fallback.local = LOCAL;
+      fallback.vecs = VECS;
+      fallback.vw = vectorWidth();
+      bench_ctx.a = a;
+      bench_ctx.b = b;
+      bench_ctx.stable = stable;
+      config = autotune(n, bench, &bench_ctx, fallback);
+      resetKernelTime();
+      init(a, N);
+      init(b, N);
+      configure(config);
+
+      local[0] = config.local;
+      global[0] = globalSize(config, n);
+      printf("vector width: %d\n", config.vw);
+      printf("elements per work item: %d\n", config.vw*config.vecs);
+      printf("work group size: %d\n", (int)local[0]);
+      printf("global work size: %d\n\n", (int)global[0]);
+
+      clock_gettime(1, &start);
+      kernels = setupKernel(KernelSource, "relax", 5, DoubleArr, n, a, DoubleArr, n, b, BoolArr, 1, stable, DoubleConst, EPS, IntConst, n);
+      // only the stability flags are needed on the host while iterating
+      setTransferPolicy(0, TransferAtEnd, 0);
+      setTransferPolicy(1, TransferAtEnd, 0);
+
+      do {         
+         // the kernel only ever clears the flag, so set it before each sweep
+         stable[0] = true;
+         pushArg(2);
+         if(count == 0) {
+            runKernelSelective(kernels.kernel1, 1, global, local);
+            count++;
+         } else {
+            runKernelSelective(kernels.kernel2, 1, global, local);
+            count--;
+         }
+         
+         iterations++;
+      } while(!stable[0]);
+      fetchFinal();
+      
+      clock_gettime(1, &stop);
+      
+      printf("Number of iterations: %d\n", iterations);
+      printTimeElapsed("CPU time spent");
+      printKernelTime();
+      
+      err = clReleaseKernel(kernels.kernel1);
+      err = clReleaseKernel(kernels.kernel2);
+      err = freeDevice();
+   }
+
+   return 0;
+}
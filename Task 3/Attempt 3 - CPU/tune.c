@@ -0,0 +1,135 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include <CL/cl.h>
+#include "simple.h"
+#include "tune.h"
+
+#define TUNE_ENV "HEAT_CL_TUNE"
+#define RETUNE_ENV "HEAT_CL_RETUNE"
+#define TUNE_DEFAULT_FILE ".cltune"
+#define LOCAL_MIN 4
+
+#define die(msg, ...) do {                      \
+  (void) fprintf (stderr, msg, ## __VA_ARGS__); \
+  (void) fprintf (stderr, "\n");                \
+} while (0)
+
+static const int vecs_candidates[] = { 1, 2, 4, 8 };
+static const int vw_candidates[] = { 2, 4, 8 };
+
+static const char *tuneFile()
+{
+  const char *file = getenv (TUNE_ENV);
+
+  return (file == NULL) ? TUNE_DEFAULT_FILE : file;
+}
+
+static int sizeBucket( int n)
+{
+  int b = 0;
+
+  while (n > 1) {
+    n /= 2;
+    b++;
+  }
+  return b;
+}
+
+/* Database lines: "<device>\t<bucket>\t<local> <vecs> <vw>\n".  */
+static bool lookup( const char *file, const char *device, int bucket,
+                    tune_config *c)
+{
+  char line[1024];
+  char *tab1, *tab2;
+  unsigned long local;
+  bool found = false;
+  FILE *f;
+
+  f = fopen (file, "r");
+  if (f == NULL)
+    return false;
+
+  while (fgets (line, sizeof (line), f) != NULL) {
+    tab1 = strchr (line, '\t');
+    tab2 = (tab1 == NULL) ? NULL : strchr (tab1 + 1, '\t');
+    if (tab2 == NULL)
+      continue;
+    *tab1 = '\0';
+    if (strcmp (line, device) != 0 || atoi (tab1 + 1) != bucket)
+      continue;
+    /* Later entries override earlier ones, e.g. after a retune.  */
+    if (sscanf (tab2 + 1, "%lu %d %d", &local, &c->vecs, &c->vw) == 3) {
+      c->local = local;
+      found = true;
+    }
+  }
+  fclose (f);
+  return found;
+}
+
+static void store( const char *file, const char *device, int bucket,
+                   tune_config c)
+{
+  FILE *f;
+
+  f = fopen (file, "a");
+  if (f == NULL) {
+    die ("Warning: Failed to write tuning database %s!", file);
+    return;
+  }
+  fprintf (f, "%s\t%d\t%lu %d %d\n", device, bucket,
+           (unsigned long) c.local, c.vecs, c.vw);
+  fclose (f);
+}
+
+tune_config autotune( int n, tune_bench bench, void *ctx,
+                      tune_config fallback)
+{
+  const char *file = tuneFile ();
+  const char *retune = getenv (RETUNE_ENV);
+  char device[600];
+  int bucket = sizeBucket (n);
+  size_t max_local;
+  tune_config best = fallback;
+  tune_config c;
+  double best_time = -1.0;
+  double t;
+
+  deviceName (device, sizeof (device));
+  /* Tabs and newlines would break the database format.  */
+  for (char *p = device; *p != '\0'; p++)
+    if (*p == '\t' || *p == '\n')
+      *p = ' ';
+
+  if (file[0] != '\0' && (retune == NULL || strcmp (retune, "0") == 0)
+      && lookup (file, device, bucket, &c))
+    return c;
+
+  max_local = maxWorkItems (0);
+  if (maxWorkGroupSize () < max_local)
+    max_local = maxWorkGroupSize ();
+
+  for (c.local = LOCAL_MIN; c.local <= max_local; c.local *= 2) {
+    for (size_t i = 0; i < sizeof (vecs_candidates) / sizeof (int); i++) {
+      for (size_t j = 0; j < sizeof (vw_candidates) / sizeof (int); j++) {
+        c.vecs = vecs_candidates[i];
+        c.vw = vw_candidates[j];
+        t = bench (c, ctx);
+        if (t >= 0.0 && (best_time < 0.0 || t < best_time)) {
+          best = c;
+          best_time = t;
+        }
+      }
+    }
+  }
+
+  if (best_time < 0.0) {
+    die ("Warning: No configuration could be tuned, using the default!");
+  } else if (file[0] != '\0') {
+    store (file, device, bucket, best);
+  }
+  return best;
+}
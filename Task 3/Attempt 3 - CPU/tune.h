@@ -0,0 +1,55 @@
+#ifndef TUNE_H_
+#define TUNE_H_
+
+#include <stddef.h>
+
+/*******************************************************************************
+ *
+ * tune_config : one point of the tuning space of the relax kernel:
+ *               - local : the work group size
+ *               - vecs  : the number of vectors per work item
+ *               - vw    : the vector width (doubles per vector)
+ *               Every work item thus handles vecs * vw elements.
+ *
+ ******************************************************************************/
+
+typedef struct {
+  size_t local;
+  int    vecs;
+  int    vw;
+} tune_config;
+
+/*******************************************************************************
+ *
+ * tune_bench : benchmarks one configuration on the selected device and
+ *              returns its run time in msec, or a negative value if the
+ *              configuration cannot run. "ctx" is passed through unchanged.
+ *
+ ******************************************************************************/
+
+typedef double (*tune_bench)( tune_config c, void *ctx);
+
+/*******************************************************************************
+ *
+ * autotune : returns the best configuration for vectors of length "n" on the
+ *            selected device. It first looks up the tuning database, which
+ *            holds one winner per device (name and driver version) and size
+ *            bucket (floor(log2(n))). On a miss it runs "bench" on every
+ *            candidate:
+ *            - local : powers of two up to the smaller of maxWorkItems(0) and
+ *                      maxWorkGroupSize()
+ *            - vecs  : 1, 2, 4, 8
+ *            - vw    : 2, 4, 8
+ *            and appends the fastest one to the database.
+ *            The database is the file named by the environment variable
+ *            HEAT_CL_TUNE (default ".cltune"); setting it to the empty string
+ *            tunes on every run without storing anything. Setting
+ *            HEAT_CL_RETUNE to a value other than "0" ignores stored entries.
+ *            If no candidate runs, "fallback" is returned.
+ *
+ ******************************************************************************/
+
+extern tune_config autotune( int n, tune_bench bench, void *ctx,
+                             tune_config fallback);
+
+#endif /* TUNE_H_ */
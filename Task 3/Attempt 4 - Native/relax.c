@@ -0,0 +1,94 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <math.h>
+#include <time.h>
+
+#include "native.h"
+
+#define N 10000000   // length of the vectors
+#define EPS 0.1      // convergence criterium
+#define HEAT 100.0   // heat value on the boundary
+
+struct timespec start, stop;
+
+void printTimeElapsed(char *text)
+{
+  double elapsed = (stop.tv_sec -start.tv_sec)*1000.0
+                  + (double)(stop.tv_nsec -start.tv_nsec)/1000000.0;
+  printf( "%s: %f msec\n", text, elapsed);
+}
+
+//
+// allocate a vector of length "n"; its pages are touched first by the
+// threads that relax them
+//
+double *allocVector(int n)
+{
+   double *v;
+   v = (double *)malloc( n*sizeof(double));
+   if (v != NULL)
+      firstTouch(v, n);
+   return v;
+}
+
+//
+// initialise the values of the given vector "out" of length "n"
+//
+void init(double *out, int n)
+{
+   int i;
+
+   for(i=1; i<n; i++) {
+      out[i] = 0;
+   }
+   out[0] = HEAT;
+}
+
+//
+// print the values of a given vector "out" of length "n"
+//
+void print(double *out, int n)
+{
+   int i;
+
+   printf("<");
+   for(i=0; i<n; i++) {
+      printf(" %f", out[i]);
+   }
+   printf(">\n");
+}
+
+int main()
+{
+   double *a,*b,*result;
+   int n;
+   int iterations = 0;
+
+   initNative();
+
+   a = allocVector(N);
+   b = allocVector(N);
+
+   init(a, N);
+   init(b, N);
+
+   n = N;
+
+   printf("size   : %d M (%d MB)\n", n/1000000, (int)(n*sizeof(double) / (1024*1024)));
+   printf("heat   : %f\n", HEAT);
+   printf("epsilon: %f\n", EPS);
+   printNativeInfo();
+
+   clock_gettime(1, &start);
+   iterations = relaxNative(a, b, n, EPS, &result);
+   clock_gettime(1, &stop);
+
+   printf("Number of iterations: %d\n", iterations);
+   printTimeElapsed("CPU time spent");
+
+   free(a);
+   free(b);
+
+   return 0;
+}
@@ -0,0 +1,299 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <immintrin.h>
+
+#include "native.h"
+
+#define THREADS_ENV "HEAT_THREADS"
+#define SIMD_ENV "HEAT_SIMD"
+#define MAX_THREADS 256
+#define ALIGN 8            /* Thread parts start at multiples of 8 doubles.  */
+
+#define die(msg, ...) do {                      \
+  (void) fprintf (stderr, msg, ## __VA_ARGS__); \
+  (void) fprintf (stderr, "\n");                \
+} while (0)
+
+/* One sweep over the interior elements [lo, hi) of a vector with the
+   weights wl and wr of the left and right neighbours; returns true iff some
+   element changed by more than eps.  */
+typedef bool (*sweep_fn) (const double *in, double *out, const double *wl,
+                          const double *wr, long lo, long hi, double eps);
+
+typedef enum {
+  SimdScalar,
+  SimdAVX2,
+  SimdAVX512
+} simd_type;
+
+static const char *simd_names[] = { "scalar", "avx2", "avx512" };
+
+/* global setup */
+
+static int num_threads = 1;
+static simd_type simd = SimdScalar;
+static sweep_fn sweep = NULL;
+static int num_cpus = 1;
+
+typedef struct {
+  int     id;
+  double *in;
+  double *out;
+  const double *wl;
+  const double *wr;
+  long    n;
+  double  eps;
+  int     sweeps;             /* Result: number of sweeps.  */
+} thread_arg;
+
+static pthread_barrier_t barrier;
+static bool unstable[2][MAX_THREADS];    /* Per sweep parity and thread.  */
+
+/* sweep kernels */
+
+static bool sweepScalar( const double *in, double *out, const double *wl,
+                         const double *wr, long lo, long hi, double eps)
+{
+  bool changed = false;
+
+  for (long i = lo; i < hi; i++) {
+    out[i] = wl[i]*in[i-1] + 0.5*in[i] + wr[i]*in[i+1];
+    if (out[i] - in[i] > eps || in[i] - out[i] > eps)
+      changed = true;
+  }
+  return changed;
+}
+
+__attribute__ ((target ("avx2,fma")))
+static bool sweepAVX2( const double *in, double *out, const double *wl,
+                       const double *wr, long lo, long hi, double eps)
+{
+  const __m256d half = _mm256_set1_pd (0.5);
+  const __m256d sign = _mm256_set1_pd (-0.0);
+  const __m256d veps = _mm256_set1_pd (eps);
+  __m256d changed = _mm256_setzero_pd ();
+  long i;
+
+  for (i = lo; i + 4 <= hi; i += 4) {
+    __m256d l = _mm256_loadu_pd (in + i - 1);
+    __m256d m = _mm256_loadu_pd (in + i);
+    __m256d r = _mm256_loadu_pd (in + i + 1);
+    __m256d o = _mm256_fmadd_pd (_mm256_loadu_pd (wl + i), l,
+                                 _mm256_fmadd_pd (half, m,
+                                                  _mm256_mul_pd (_mm256_loadu_pd (wr + i), r)));
+    _mm256_storeu_pd (out + i, o);
+    changed = _mm256_or_pd (changed,
+                            _mm256_cmp_pd (_mm256_andnot_pd (sign,
+                                                             _mm256_sub_pd (o, m)),
+                                           veps, _CMP_GT_OQ));
+  }
+  return (_mm256_movemask_pd (changed) != 0)
+           | sweepScalar (in, out, wl, wr, i, hi, eps);
+}
+
+__attribute__ ((target ("avx512f")))
+static bool sweepAVX512( const double *in, double *out, const double *wl,
+                         const double *wr, long lo, long hi, double eps)
+{
+  const __m512d half = _mm512_set1_pd (0.5);
+  const __m512d veps = _mm512_set1_pd (eps);
+  __mmask8 changed = 0;
+  long i;
+
+  for (i = lo; i + 8 <= hi; i += 8) {
+    __m512d l = _mm512_loadu_pd (in + i - 1);
+    __m512d m = _mm512_loadu_pd (in + i);
+    __m512d r = _mm512_loadu_pd (in + i + 1);
+    __m512d o = _mm512_fmadd_pd (_mm512_loadu_pd (wl + i), l,
+                                 _mm512_fmadd_pd (half, m,
+                                                  _mm512_mul_pd (_mm512_loadu_pd (wr + i), r)));
+    _mm512_storeu_pd (out + i, o);
+    changed |= _mm512_cmp_pd_mask (_mm512_abs_pd (_mm512_sub_pd (o, m)),
+                                   veps, _CMP_GT_OQ);
+  }
+  return (changed != 0) | sweepScalar (in, out, wl, wr, i, hi, eps);
+}
+
+/* thread management */
+
+/* Part [*lo, *hi) of a vector of length n that belongs to thread t.  */
+static void threadPart( int t, long n, long *lo, long *hi)
+{
+  *lo = (t == 0) ? 0 : ((n * t / num_threads) & ~(long) (ALIGN - 1));
+  *hi = (t == num_threads - 1) ? n
+          : ((n * (t + 1) / num_threads) & ~(long) (ALIGN - 1));
+}
+
+/* Pin the calling thread to one CPU, so its pages stay local.  */
+static void pinThread( int t)
+{
+  cpu_set_t set;
+
+  CPU_ZERO (&set);
+  CPU_SET (t % num_cpus, &set);
+  if (pthread_setaffinity_np (pthread_self (), sizeof (set), &set) != 0)
+    die ("Warning: Failed to pin thread %d!", t);
+}
+
+static void runThreads( void *(*fn) (void *), thread_arg *args)
+{
+  pthread_t threads[MAX_THREADS];
+
+  for (int t = 1; t < num_threads; t++)
+    if (pthread_create (&threads[t], NULL, fn, &args[t]) != 0) {
+      die ("Error: Failed to create thread %d!", t);
+      exit (1);
+    }
+  fn (&args[0]);
+  for (int t = 1; t < num_threads; t++)
+    pthread_join (threads[t], NULL);
+}
+
+static void *touchThread( void *p)
+{
+  thread_arg *arg = (thread_arg *) p;
+  long lo, hi;
+
+  pinThread (arg->id);
+  threadPart (arg->id, arg->n, &lo, &hi);
+  memset (arg->out + lo, 0, (hi - lo) * sizeof (double));
+  return NULL;
+}
+
+static void *relaxThread( void *p)
+{
+  thread_arg *arg = (thread_arg *) p;
+  const double *in = arg->in;
+  double *out = arg->out;
+  double *tmp;
+  long n = arg->n;
+  long lo, hi;
+  bool stable;
+  int s = 0;
+
+  pinThread (arg->id);
+  threadPart (arg->id, n, &lo, &hi);
+
+  /* The boundary elements never change: copy them once into both vectors.  */
+  if (lo == 0)
+    out[0] = in[0];
+  if (hi == n)
+    out[n-1] = in[n-1];
+  if (lo == 0)
+    lo = 1;
+  if (hi == n)
+    hi = n - 1;
+
+  do {
+    unstable[s % 2][arg->id] = (lo < hi) && sweep (in, out, arg->wl, arg->wr,
+                                                   lo, hi, arg->eps);
+    /* One barrier per sweep: the flags alternate by parity, so a thread
+       reads the flags of sweep s before anyone can overwrite them in s+2.  */
+    pthread_barrier_wait (&barrier);
+    stable = true;
+    for (int t = 0; t < num_threads; t++)
+      stable = stable && !unstable[s % 2][t];
+    tmp = (double *) in;
+    in = out;
+    out = tmp;
+    s++;
+  } while (!stable);
+
+  arg->sweeps = s;
+  return NULL;
+}
+
+/* public interface */
+
+int initNative ()
+{
+  const char *env;
+  long cpus;
+
+  cpus = sysconf (_SC_NPROCESSORS_ONLN);
+  num_cpus = (cpus > 0) ? (int) cpus : 1;
+  num_threads = num_cpus;
+  env = getenv (THREADS_ENV);
+  if (env != NULL && atoi (env) > 0)
+    num_threads = atoi (env);
+  if (num_threads > MAX_THREADS)
+    num_threads = MAX_THREADS;
+
+  __builtin_cpu_init ();
+  if (__builtin_cpu_supports ("avx512f"))
+    simd = SimdAVX512;
+  else if (__builtin_cpu_supports ("avx2") && __builtin_cpu_supports ("fma"))
+    simd = SimdAVX2;
+  else
+    simd = SimdScalar;
+
+  env = getenv (SIMD_ENV);
+  if (env != NULL) {
+    if (strcmp (env, "scalar") == 0)
+      simd = SimdScalar;
+    else if (strcmp (env, "avx2") == 0 && simd >= SimdAVX2)
+      simd = SimdAVX2;
+    else if (strcmp (env, "avx512") != 0 && strcmp (env, "avx2") != 0)
+      die ("Warning: Unknown %s \"%s\", using %s!", SIMD_ENV, env,
+           simd_names[simd]);
+  }
+
+  switch (simd) {
+    case SimdAVX512:
+      sweep = sweepAVX512;
+      break;
+    case SimdAVX2:
+      sweep = sweepAVX2;
+      break;
+    default:
+      sweep = sweepScalar;
+  }
+  return 0;
+}
+
+void firstTouch( double *v, int n)
+{
+  thread_arg args[MAX_THREADS];
+
+  for (int t = 0; t < num_threads; t++) {
+    args[t].id = t;
+    args[t].out = v;
+    args[t].n = n;
+  }
+  runThreads (touchThread, args);
+}
+
+int relaxNative( double *in, double *out, const double *wl, const double *wr,
+                 int n, double eps, double **result)
+{
+  thread_arg args[MAX_THREADS];
+
+  if (pthread_barrier_init (&barrier, NULL, num_threads) != 0) {
+    die ("Error: Failed to create barrier!");
+    return 0;
+  }
+  for (int t = 0; t < num_threads; t++) {
+    args[t].id = t;
+    args[t].in = in;
+    args[t].out = out;
+    args[t].wl = wl;
+    args[t].wr = wr;
+    args[t].n = n;
+    args[t].eps = eps;
+  }
+  runThreads (relaxThread, args);
+  pthread_barrier_destroy (&barrier);
+
+  *result = (args[0].sweeps % 2 == 1) ? out : in;
+  return args[0].sweeps;
+}
+
+void printNativeInfo()
+{
+  printf ("Engine: native, %s, %d thread(s)\n", simd_names[simd], num_threads);
+}
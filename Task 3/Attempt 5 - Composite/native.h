@@ -0,0 +1,54 @@
+#ifndef NATIVE_H_
+#define NATIVE_H_
+
+#include <stdbool.h>
+
+/*******************************************************************************
+ *
+ * initNative : sets up the native engine: it detects the instruction set of
+ *              the host CPU (AVX-512, AVX2 or plain scalar code) and the
+ *              number of threads. Both can be overridden by the environment
+ *              variables HEAT_SIMD ("avx512", "avx2" or "scalar") and
+ *              HEAT_THREADS. Asking for an instruction set the CPU does not
+ *              support falls back to the best one it does.
+ *              Returns 0 on success.
+ *
+ ******************************************************************************/
+extern int initNative ();
+
+/*******************************************************************************
+ *
+ * firstTouch : writes zeros to the vector "v" of length "n", every thread
+ *              the part it will later relax. Freshly allocated pages are
+ *              placed on the NUMA node of the thread that touches them
+ *              first, so calling this right after allocation keeps every
+ *              thread's part of the vector in its local memory.
+ *
+ ******************************************************************************/
+extern void firstTouch( double *v, int n);
+
+/*******************************************************************************
+ *
+ * relaxNative : relaxes "in" into "out" (both of length "n") until a sweep
+ *               changes no element by more than "eps". The semantics are the
+ *               ones of the relax kernel: the first and the last element
+ *               are kept, all others become
+ *               wl[i]*left + 0.5*self + wr[i]*right,
+ *               and the two vectors swap roles after every sweep. The
+ *               weights must satisfy wl[i] + wr[i] = 0.5.
+ *               Returns the number of sweeps; "*result" is set to the
+ *               vector that holds the final values.
+ *
+ ******************************************************************************/
+extern int relaxNative( double *in, double *out, const double *wl,
+                        const double *wr, int n, double eps, double **result);
+
+/*******************************************************************************
+ *
+ * printNativeInfo : prints the selected instruction set and the number of
+ *                   threads to stdout.
+ *
+ ******************************************************************************/
+extern void printNativeInfo();
+
+#endif /* NATIVE_H_ */
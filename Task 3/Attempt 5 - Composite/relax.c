@@ -0,0 +1,247 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <math.h>
+#include <time.h>
+
+#include <CL/cl.h>
+#include "simple.h"
+#include "native.h"
+
+#define N 10000000   // length of the vectors
+#define EPS 0.1      // convergence criterium
+#define HEAT 100.0   // heat value on the boundary
+
+#define LAYERS 10    // the rod alternates between LAYERS layers of
+#define K_A 1.0      // a material with conductivity K_A
+#define K_B 0.1      // and one with conductivity K_B
+#define CHUNK 10     // elements per work item
+
+struct timespec start, stop;
+
+void printTimeElapsed(char *text)
+{
+  double elapsed = (stop.tv_sec -start.tv_sec)*1000.0
+                  + (double)(stop.tv_nsec -start.tv_nsec)/1000000.0;
+  printf( "%s: %f msec\n", text, elapsed);
+}
+
+//
+// allocate a vector of length "n"
+//
+double *allocVector(int n)
+{
+   double *v;
+   v = (double *)allocHost( n*sizeof(double));
+   return v;
+}
+
+//
+// allocate a bool vector of length "n"
+//
+bool *allocStable(int n)
+{
+   bool *s;
+   s = (bool *)malloc( n*sizeof(bool));
+   return s;
+}
+
+//
+// initialise the values of the given vector "out" of length "n"
+//
+void init(double *out, int n)
+{
+   int i;
+
+   for(i=1; i<n; i++) {
+      out[i] = 0;
+   }
+   out[0] = HEAT;
+}
+
+//
+// initialise the values of the given vector "out" of length "n"
+//
+void binit(bool *out, int n)
+{
+   int i;
+
+   for(i=0; i<n; i++) {
+      out[i] = false;
+   }
+}
+
+//
+// print the values of a given vector "out" of length "n"
+//
+void print(double *out, int n)
+{
+   int i;
+
+   printf("<");
+   for(i=0; i<n; i++) {
+      printf(" %f", out[i]);
+   }
+   printf(">\n");
+}
+
+//
+// conductivity of the "n"-1 faces of a rod of length "n": face i lies
+// between the elements i and i+1 and gets the harmonic mean of their
+// materials, which keeps the heat flux continuous across a layer boundary
+//
+void conductivity(double *k, int n)
+{
+   double left, right;
+   int i;
+
+   for(i=0; i<n-1; i++) {
+      left = ((long)i * LAYERS / n) % 2 == 0 ? K_A : K_B;
+      right = ((long)(i+1) * LAYERS / n) % 2 == 0 ? K_A : K_B;
+      k[i] = 2.0 * left * right / (left + right);
+   }
+}
+
+//
+// normalised weights of the left and right neighbours from the face
+// conductivities "k": the relax sweep becomes
+// out[i] = wl[i]*in[i-1] + 0.5*in[i] + wr[i]*in[i+1], whose steady state
+// balances the fluxes k[i-1]*(in[i-1] - in[i]) and k[i]*(in[i] - in[i+1]).
+// For a uniform rod the weights are the 0.25 of the plain relax kernel. They
+// are kept as two separate arrays (SoA), so the sweep streams three vectors
+// with unit stride and needs no division.
+//
+void weights(double *k, double *wl, double *wr, int n)
+{
+   int i;
+
+   wl[0] = wr[0] = 0.0;
+   wl[n-1] = wr[n-1] = 0.0;
+   for(i=1; i<n-1; i++) {
+      wl[i] = 0.5 * k[i-1] / (k[i-1] + k[i]);
+      wr[i] = 0.5 * k[i] / (k[i-1] + k[i]);
+   }
+}
+
+//
+//relax function in kernel source: every work item relaxes a chunk of
+//elements with the per-element weights wl and wr
+//
+const char *KernelSource =                                       "\n"
+  "__kernel void relax(                                          \n"
+  "   __global double* in,                                       \n"
+  "   __global double* out,                                      \n"
+  "   __global double* wl,                                       \n"
+  "   __global double* wr,                                       \n"
+  "   __global bool* stable,                                     \n"
+  "   const double eps,                                          \n"
+  "   const unsigned int count)                                  \n"
+  "{                                                             \n"
+  "   int i = get_global_id(0);                                  \n"
+  "   int n = get_global_size(0);                                \n"
+  "   int chunk = (count + n - 1) / n;                           \n"
+  "   int lo = i * chunk;                                        \n"
+  "   int hi = min(lo + chunk, (int)count);                      \n"
+  "   for (int j = lo; j < hi; j++) {                            \n"
+  "      if (j > 0 && j < count-1) {                             \n"
+  "         out[j] = wl[j]*in[j-1] + 0.5*in[j] + wr[j]*in[j+1];  \n"
+  "      } else {                                                \n"
+  "         out[j] = in[j];                                      \n"
+  "      }                                                       \n"
+  "      if (fabs(in[j] - out[j]) > eps)                         \n"
+  "         stable[0] = false;                                   \n"
+  "   }                                                          \n"
+  "}                                                             \n"
+  "\n";
+
+int main()
+{
+   cl_int err;
+   kernel_struct kernels;
+   size_t global[1];
+   size_t local[1];
+  
+   double *a,*b,*result;
+   double *k,*wl,*wr;
+   bool *stable;
+   int n, count;
+   int iterations = 0;
+
+   a = allocVector(N);
+   b = allocVector(N);
+   wl = allocVector(N);
+   wr = allocVector(N);
+   k = allocVector(N-1);
+   stable = allocStable(1);
+
+   init(a, N);
+   init(b, N);
+   binit(stable, 1);
+
+   n = N;
+   count = 0;
+   conductivity(k, n);
+   weights(k, wl, wr, n);
+   free(k);
+   
+   local[0] = 32;
+   printf("work group size: %d\n", (int)local[0]);
+   global[0] = (((n + CHUNK - 1) / CHUNK + local[0] - 1) / local[0]) * local[0];
+   printf("global work size: %d\n\n", (int)global[0]);
+
+   printf("size   : %d M (%d MB)\n", n/1000000, (int)(n*sizeof(double) / (1024*1024)));
+   printf("heat   : %f\n", HEAT);
+   printf("epsilon: %f\n", EPS);
+   printf("layers : %d, conductivity %f / %f\n", LAYERS, K_A, K_B);
+   
+   err = initCPU();
+   //clPrintDevInfo();
+      
+   if (err == CL_SUCCESS) {
+      clock_gettime(1, &start);
+      kernels = setupKernel(KernelSource, "relax", 7, DoubleArr, n, a, DoubleArr, n, b, DoubleArr, n, wl, DoubleArr, n, wr, BoolArr, 1, stable, DoubleConst, EPS, IntConst, n);
+      // only the stability flags are needed on the host while iterating
+      setTransferPolicy(0, TransferAtEnd, 0);
+      setTransferPolicy(1, TransferAtEnd, 0);
+      setTransferPolicy(2, TransferNever, 0);
+      setTransferPolicy(3, TransferNever, 0);
+
+      do {         
+         // every work group may clear the flag, so only the host sets it
+         stable[0] = true;
+         pushArg(4);
+         if(count == 0) {
+            runKernelSelective(kernels.kernel1, 1, global, local);
+            count++;
+         } else {
+            runKernelSelective(kernels.kernel2, 1, global, local);
+            count--;
+         }
+         
+         iterations++;
+      } while(!stable[0]);
+      fetchFinal();
+      
+      clock_gettime(1, &stop);
+      
+      printf("Number of iterations: %d\n", iterations);
+      printTimeElapsed("CPU time spent");
+      printKernelTime();
+      
+      err = clReleaseKernel(kernels.kernel1);
+      err = clReleaseKernel(kernels.kernel2);
+      err = freeDevice();
+   } else {
+      printf("no OpenCL device, relaxing natively\n");
+      initNative();
+      printNativeInfo();
+      clock_gettime(1, &start);
+      iterations = relaxNative(a, b, wl, wr, n, EPS, &result);
+      clock_gettime(1, &stop);
+
+      printf("Number of iterations: %d\n", iterations);
+      printTimeElapsed("CPU time spent");
+   }
+
+   return 0;
+}
@@ -0,0 +1,171 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stdbool.h>
+
+#include "gen.h"
+
+#define die(msg, ...) do {                      \
+  (void) fprintf (stderr, msg, ## __VA_ARGS__); \
+  (void) fprintf (stderr, "\n");                \
+} while (0)
+
+/* growing source buffer */
+
+typedef struct {
+  char  *s;
+  size_t len;
+  size_t size;
+} buffer;
+
+static void append( buffer *b, const char *fmt, ...)
+{
+  va_list ap;
+  int len;
+
+  va_start (ap, fmt);
+  len = vsnprintf (NULL, 0, fmt, ap);
+  va_end (ap);
+  if (len < 0)
+    return;
+
+  if (b->len + len + 1 > b->size) {
+    size_t size = (b->size == 0) ? 4096 : b->size;
+    char *s;
+
+    while (b->len + len + 1 > size)
+      size *= 2;
+    s = (char *) realloc (b->s, size);
+    if (s == NULL) {
+      die ("Error: Failed to allocate %zu bytes for the kernel source!", size);
+      return;
+    }
+    b->s = s;
+    b->size = size;
+  }
+
+  va_start (ap, fmt);
+  vsnprintf (b->s + b->len, b->size - b->len, fmt, ap);
+  va_end (ap);
+  b->len += len;
+}
+
+/* Appends the weighted sum of the stencil around "in[i + at]", where
+   "load" is a printf format that turns an offset from i into a load
+   ("in[i%+d]" or "vload4(0, in + i%+d)").  */
+static void appendStencil( buffer *b, const stencil_desc *s, const char *load,
+                           int at)
+{
+  for (int k = -s->radius; k <= s->radius; k++) {
+    append (b, (k == -s->radius) ? "(REAL)(W%d) * " : "\n             + (REAL)(W%d) * ",
+            k + s->radius);
+    append (b, load, at + k);
+  }
+}
+
+/* public interface */
+
+bool genCheck( const stencil_desc *s)
+{
+  if (s->radius < 1 || s->radius > GEN_MAX_RADIUS) {
+    die ("Error: Stencil radius %d is not in 1..%d!", s->radius, GEN_MAX_RADIUS);
+    return false;
+  }
+  if (s->vw != 1 && s->vw != 2 && s->vw != 4 && s->vw != 8 && s->vw != 16) {
+    die ("Error: Vector width %d is not 1, 2, 4, 8 or 16!", s->vw);
+    return false;
+  }
+  if (s->elems < 1 || s->elems % s->vw != 0) {
+    die ("Error: %d elements per work item are no multiple of the vector width %d!",
+         s->elems, s->vw);
+    return false;
+  }
+  return true;
+}
+
+char *genSource( const stencil_desc *s)
+{
+  buffer b = { NULL, 0, 0 };
+  const char *type = (s->type == GenFloat) ? "float" : "double";
+  char load[32];
+
+  if (!genCheck (s))
+    return NULL;
+
+  append (&b, "#define REAL %s\n", type);
+  if (s->vw > 1)
+    append (&b, "#define REALV %s%d\n", type, s->vw);
+  append (&b, "\n"
+              "__kernel void relax(\n"
+              "   __global REAL* in,\n"
+              "   __global REAL* out,\n"
+              "   __global bool* stable)\n"
+              "{\n"
+              "   int i = get_global_id(0) * %d;\n"
+              "   bool changed = false;\n"
+              "\n",
+          s->elems);
+
+  /* Interior work items: no bounds checks, vector loads and stores.  */
+  append (&b, "   if (i >= %d && i + %d <= N - %d) {\n",
+          s->radius, s->elems, s->radius);
+  if (s->vw > 1)
+    snprintf (load, sizeof (load), "vload%d(0, in + i%%+d)", s->vw);
+  else
+    snprintf (load, sizeof (load), "in[i%%+d]");
+  for (int v = 0; v < s->elems; v += s->vw) {
+    append (&b, "      {\n");
+    if (s->vw > 1) {
+      append (&b, "         REALV c = vload%d(0, in + i%+d);\n", s->vw, v);
+      append (&b, "         REALV o = ");
+    } else {
+      append (&b, "         REAL c = in[i%+d];\n", v);
+      append (&b, "         REAL o = ");
+    }
+    appendStencil (&b, s, load, v);
+    append (&b, ";\n");
+    if (s->vw > 1) {
+      append (&b, "         vstore%d(o, 0, out + i%+d);\n", s->vw, v);
+      append (&b, "         changed = changed || any(fabs(o - c) > (REAL)(EPS));\n");
+    } else {
+      append (&b, "         out[i%+d] = o;\n", v);
+      append (&b, "         changed = changed || fabs(o - c) > (REAL)(EPS);\n");
+    }
+    append (&b, "      }\n");
+  }
+
+  /* Work items at the ends of the vector: scalar, element by element.  */
+  append (&b, "   } else {\n");
+  for (int j = 0; j < s->elems; j++) {
+    append (&b, "      if (i%+d < N) {\n"
+                "         REAL c = in[i%+d];\n"
+                "         REAL o = c;\n"
+                "         if (i%+d >= %d && i%+d < N - %d)\n"
+                "            o = ",
+            j, j, j, s->radius, j, s->radius);
+    appendStencil (&b, s, "in[i%+d]", j);
+    append (&b, ";\n"
+                "         out[i%+d] = o;\n"
+                "         changed = changed || fabs(o - c) > (REAL)(EPS);\n"
+                "      }\n",
+            j);
+  }
+  append (&b, "   }\n"
+              "\n"
+              "   if (changed)\n"
+              "      stable[0] = false;\n"
+              "}\n");
+
+  return b.s;
+}
+
+char *genOptions( const stencil_desc *s, int n, double eps)
+{
+  buffer b = { NULL, 0, 0 };
+
+  append (&b, "-D N=%d -D EPS=%.17g", n, eps);
+  for (int k = 0; k <= 2 * s->radius; k++)
+    append (&b, " -D W%d=%.17g", k, s->weights[k]);
+
+  return b.s;
+}
@@ -0,0 +1,71 @@
+#ifndef GEN_H_
+#define GEN_H_
+
+#include <stdbool.h>
+
+#define GEN_MAX_RADIUS 4
+
+typedef enum {
+  GenDouble,
+  GenFloat
+} gen_type;
+
+/*******************************************************************************
+ *
+ * stencil_desc : describes a 1D Jacobi stencil and the shape of the kernel
+ *                that applies it:
+ *               - radius  : neighbours on each side (1 .. GEN_MAX_RADIUS);
+ *                           the first and last <radius> elements are kept
+ *               - weights : 2*radius+1 weights, from the leftmost neighbour
+ *                           to the rightmost one
+ *               - type    : element type of the vectors
+ *               - elems   : elements relaxed by one work item
+ *               - vw      : vector width (1, 2, 4, 8 or 16); elems must be
+ *                           a multiple of it
+ *
+ ******************************************************************************/
+typedef struct {
+  int      radius;
+  double   weights[2*GEN_MAX_RADIUS + 1];
+  gen_type type;
+  int      elems;
+  int      vw;
+} stencil_desc;
+
+/*******************************************************************************
+ *
+ * genCheck : returns true iff "s" describes a stencil genSource can emit.
+ *
+ ******************************************************************************/
+extern bool genCheck( const stencil_desc *s);
+
+/*******************************************************************************
+ *
+ * genSource : returns the openCL source of a kernel "relax" for "s", with
+ *             the arguments
+ *               __global type *in, __global type *out, __global bool *stable
+ *             The loop over the elements of a work item and the stencil are
+ *             fully unrolled. The source only depends on the shape of the
+ *             kernel (radius, type, elems, vw); the weights, the vector
+ *             length and eps are left to the macros set by genOptions.
+ *             The kernel only ever clears stable[0], so the caller sets it
+ *             before each launch.
+ *             The source is allocated with malloc; NULL if "s" is invalid.
+ *
+ ******************************************************************************/
+extern char *genSource( const stencil_desc *s);
+
+/*******************************************************************************
+ *
+ * genOptions : returns the build options that specialise the source of
+ *              genSource for "s", a vector of length "n" and the convergence
+ *              bound "eps": "-D N=.. -D EPS=.. -D W0=.. -D W1=.." with all
+ *              values printed exactly. Passed to setBuildOptions they let the
+ *              compiler fold the constants; createKernel keeps every built
+ *              specialisation, and the program cache keys its binaries on
+ *              the options as well. Allocated with malloc.
+ *
+ ******************************************************************************/
+extern char *genOptions( const stencil_desc *s, int n, double eps);
+
+#endif /* GEN_H_ */
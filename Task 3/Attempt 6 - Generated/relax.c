@@ -0,0 +1,194 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <math.h>
+#include <time.h>
+
+#include <CL/cl.h>
+#include "simple.h"
+#include "gen.h"
+
+#define N 10000000   // length of the vectors
+#define EPS 0.1      // convergence criterium
+#define HEAT 100.0   // heat value on the boundary
+
+#define ELEMS 16     // elements per work item
+#define VW_MAX 8     // upper bound for the vector width
+
+struct timespec start, stop;
+
+void printTimeElapsed(char *text)
+{
+  double elapsed = (stop.tv_sec -start.tv_sec)*1000.0
+                  + (double)(stop.tv_nsec -start.tv_nsec)/1000000.0;
+  printf( "%s: %f msec\n", text, elapsed);
+}
+
+//
+// allocate a vector of length "n"
+//
+double *allocVector(int n)
+{
+   double *v;
+   v = (double *)allocHost( n*sizeof(double));
+   return v;
+}
+
+//
+// allocate a bool vector of length "n"
+//
+bool *allocStable(int n)
+{
+   bool *s;
+   s = (bool *)allocHost( n*sizeof(bool));
+   return s;
+}
+
+//
+// initialise the values of the given vector "out" of length "n"
+//
+void init(double *out, int n)
+{
+   int i;
+
+   for(i=1; i<n; i++) {
+      out[i] = 0;
+   }
+   out[0] = HEAT;
+}
+
+//
+// initialise the values of the given vector "out" of length "n"
+//
+void binit(bool *out, int n)
+{
+   int i;
+
+   for(i=0; i<n; i++) {
+      out[i] = false;
+   }
+}
+
+//
+// print the values of a given vector "out" of length "n"
+//
+void print(double *out, int n)
+{
+   int i;
+
+   printf("<");
+   for(i=0; i<n; i++) {
+      printf(" %f", out[i]);
+   }
+   printf(">\n");
+}
+
+//
+// vector width for the kernel: the preferred double vector width of the
+// device, rounded down to a power of two in [1, VW_MAX]
+//
+int vectorWidth()
+{
+   int pref = preferredVectorWidthDouble();
+   int vw = 1;
+
+   while (vw * 2 <= pref && vw * 2 <= VW_MAX)
+      vw *= 2;
+   return vw;
+}
+
+//
+// the relax stencil: 0.25*left + 0.5*self + 0.25*right on doubles
+//
+stencil_desc relaxStencil(int vw)
+{
+   stencil_desc s = { 1, { 0.25, 0.5, 0.25 }, GenDouble, ELEMS, vw };
+
+   return s;
+}
+
+int main()
+{
+   cl_int err;
+   kernel_struct kernels;
+   size_t global[1];
+   size_t local[1];
+  
+   double *a,*b;
+   bool *stable;
+   stencil_desc stencil;
+   char *source, *options;
+   int n, count;
+   int iterations = 0;
+
+   a = allocVector(N);
+   b = allocVector(N);
+   stable = allocStable(1);
+
+   init(a, N);
+   init(b, N);
+   binit(stable, 1);
+
+   n = N;
+   count = 0;
+
+   printf("size   : %d M (%d MB)\n", n/1000000, (int)(n*sizeof(double) / (1024*1024)));
+   printf("heat   : %f\n", HEAT);
+   printf("epsilon: %f\n", EPS);
+   
+   err = initCPU();
+   //clPrintDevInfo();
+      
+   if (err == CL_SUCCESS) {
+      stencil = relaxStencil(vectorWidth());
+      source = genSource(&stencil);
+      options = genOptions(&stencil, n, EPS);
+      if (source == NULL || options == NULL)
+         return 1;
+      setBuildOptions(options);
+
+      local[0] = 32;
+      printf("work group size: %d\n", (int)local[0]);
+      global[0] = (((n + ELEMS - 1) / ELEMS + local[0] - 1) / local[0]) * local[0];
+      printf("global work size: %d\n", (int)global[0]);
+      printf("stencil: radius %d, %d elements of %d per item\n",
+             stencil.radius, stencil.elems, stencil.vw);
+      printf("options: %s\n\n", options);
+
+      clock_gettime(1, &start);
+      kernels = setupKernel(source, "relax", 3, DoubleArr, n, a, DoubleArr, n, b, BoolArr, 1, stable);
+      // only the stability flags are needed on the host while iterating
+      setTransferPolicy(0, TransferAtEnd, 0);
+      setTransferPolicy(1, TransferAtEnd, 0);
+
+      do {         
+         // the generated kernel can only clear the flag
+         stable[0] = true;
+         pushArg(2);
+         if(count == 0) {
+            runKernelSelective(kernels.kernel1, 1, global, local);
+            count++;
+         } else {
+            runKernelSelective(kernels.kernel2, 1, global, local);
+            count--;
+         }
+         
+         iterations++;
+      } while(!stable[0]);
+      fetchFinal();
+      
+      clock_gettime(1, &stop);
+      
+      printf("Number of iterations: %d\n", iterations);
+      printTimeElapsed("CPU time spent");
+      printKernelTime();
+      
+      err = clReleaseKernel(kernels.kernel1);
+      err = clReleaseKernel(kernels.kernel2);
+      err = freeDevice();
+      free(source);
+      free(options);
+   }
+
+   return 0;
+}
@@ -0,0 +1,392 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include <CL/cl.h>
+#include "multi.h"
+
+#define MAX_PARTS 64
+#define MAX_PLATFORMS 8
+#define MAX_DEVICES 16
+#define NUMA_ENV "HEAT_CL_NUMA"
+
+#define die(msg, ...) do {                      \
+  (void) fprintf (stderr, msg, ## __VA_ARGS__); \
+  (void) fprintf (stderr, "\n");                \
+} while (0)
+
+typedef struct {
+  cl_device_id     device;
+  bool             sub;           /* Created by clCreateSubDevices.  */
+  cl_uint          units;         /* Compute units.  */
+  int              ctx;           /* Index of the context.  */
+  cl_command_queue queue;
+  cl_kernel        kernel;
+  cl_mem           buf[2];        /* Cells plus a halo cell on either side.  */
+  cl_mem           flag;          /* Unstable flag of the sweep.  */
+  int              first;         /* Global index of cell 0 of the buffers.  */
+  int              len;           /* Cells owned: 1 .. len in the buffers.  */
+  int              unstable;      /* Flag read back after the sweep.  */
+  double           edge[2][2];    /* First and last owned cell, per parity.  */
+} part;
+
+/* global setup */
+
+static part parts[MAX_PARTS];
+static int num_parts = 0;
+static cl_context contexts[MAX_PLATFORMS];
+static cl_program programs[MAX_PLATFORMS];
+static int num_contexts = 0;
+static int sweeps = 0;
+static const int zero = 0;
+
+/* Adds the device "dev" as one part, or one part per NUMA node if it is a
+   CPU that can be split.  */
+static void addDevice( cl_device_id dev, cl_device_type type, bool numa)
+{
+  cl_device_partition_property props[] = {
+    CL_DEVICE_PARTITION_BY_AFFINITY_DOMAIN, CL_DEVICE_AFFINITY_DOMAIN_NUMA, 0
+  };
+  cl_device_id subs[MAX_PARTS];
+  cl_uint num_subs = 0;
+
+  if (numa && (type & CL_DEVICE_TYPE_CPU)
+       && (CL_SUCCESS == clCreateSubDevices (dev, props, MAX_PARTS - num_parts,
+                                             subs, &num_subs))
+       && (num_subs > 1)) {
+    for (cl_uint i = 0; i < num_subs; i++) {
+      parts[num_parts].device = subs[i];
+      parts[num_parts].sub = true;
+      num_parts++;
+    }
+    return;
+  }
+  /* A single NUMA node: the sub-device is the whole device.  */
+  for (cl_uint i = 0; i < num_subs; i++)
+    clReleaseDevice (subs[i]);
+  parts[num_parts].device = dev;
+  parts[num_parts].sub = false;
+  num_parts++;
+}
+
+/* public interface */
+
+int initMulti ()
+{
+  cl_int err = CL_SUCCESS;
+  cl_platform_id platforms[MAX_PLATFORMS];
+  cl_device_id devices[MAX_DEVICES];
+  cl_device_id ctx_devices[MAX_PARTS];
+  cl_device_type type;
+  cl_uint num_platforms = 0;
+  cl_uint num_devices;
+  bool have_cpu = false;
+  bool numa;
+  int p0;
+
+  numa = !((getenv (NUMA_ENV) != NULL) && (strcmp (getenv (NUMA_ENV), "0") == 0));
+
+  err = clGetPlatformIDs (MAX_PLATFORMS, platforms, &num_platforms);
+  if (CL_SUCCESS != err) {
+    die ("Error: Failed to find a platform!");
+    return 0;
+  }
+  if (num_platforms > MAX_PLATFORMS)
+    num_platforms = MAX_PLATFORMS;
+
+  for (cl_uint i = 0; i < num_platforms; i++) {
+    num_devices = 0;
+    if (CL_SUCCESS != clGetDeviceIDs (platforms[i], CL_DEVICE_TYPE_ALL,
+                                      MAX_DEVICES, devices, &num_devices))
+      continue;
+    if (num_devices > MAX_DEVICES)
+      num_devices = MAX_DEVICES;
+
+    p0 = num_parts;
+    for (cl_uint d = 0; (d < num_devices) && (num_parts < MAX_PARTS); d++) {
+      clGetDeviceInfo (devices[d], CL_DEVICE_TYPE, sizeof (type), &type, NULL);
+      if (type & CL_DEVICE_TYPE_CPU) {
+        if (have_cpu)
+          continue;
+        have_cpu = true;
+      }
+      addDevice (devices[d], type, numa);
+    }
+    if (num_parts == p0)
+      continue;
+
+    /* One context for the parts of this platform.  */
+    cl_context_properties props[] = {
+      CL_CONTEXT_PLATFORM, (cl_context_properties) platforms[i], 0
+    };
+    for (int p = p0; p < num_parts; p++)
+      ctx_devices[p - p0] = parts[p].device;
+    contexts[num_contexts] = clCreateContext (props, num_parts - p0, ctx_devices,
+                                              NULL, NULL, &err);
+    if (!contexts[num_contexts] || err != CL_SUCCESS) {
+      die ("Error: Failed to create a compute context!");
+      for (int p = p0; p < num_parts; p++)
+        if (parts[p].sub)
+          clReleaseDevice (parts[p].device);
+      num_parts = p0;
+      continue;
+    }
+    for (int p = p0; p < num_parts; p++) {
+      parts[p].ctx = num_contexts;
+      parts[p].units = 1;
+      clGetDeviceInfo (parts[p].device, CL_DEVICE_MAX_COMPUTE_UNITS,
+                       sizeof (cl_uint), &parts[p].units, NULL);
+      if (parts[p].units == 0)
+        parts[p].units = 1;
+      parts[p].queue = clCreateCommandQueue (contexts[num_contexts],
+                                             parts[p].device, 0, &err);
+      if (!parts[p].queue || err != CL_SUCCESS) {
+        die ("Error: Failed to create a command queue for part %d!", p);
+        parts[p].queue = NULL;
+      }
+    }
+    programs[num_contexts] = NULL;
+    num_contexts++;
+  }
+
+  /* Parts without a queue cannot take part.  */
+  p0 = 0;
+  for (int p = 0; p < num_parts; p++) {
+    if (parts[p].queue != NULL)
+      parts[p0++] = parts[p];
+    else if (parts[p].sub)
+      clReleaseDevice (parts[p].device);
+  }
+  num_parts = p0;
+
+  if (num_parts == 0)
+    die ("Error: Failed to find a device!");
+  return num_parts;
+}
+
+cl_int setupMulti( const char *kernel_source, char *kernel_name,
+                   double *v, int n, double eps)
+{
+  cl_int err = CL_SUCCESS;
+  long total_units = 0;
+  long units = 0;
+  int lo, hi, g0, g1;
+
+  if (n < 2 * num_parts) {
+    die ("Error: %d cells are too few for %d parts!", n, num_parts);
+    return CL_INVALID_VALUE;
+  }
+
+  for (int c = 0; c < num_contexts; c++) {
+    programs[c] = clCreateProgramWithSource (contexts[c], 1,
+                                             (const char **) &kernel_source,
+                                             NULL, &err);
+    if (!programs[c] || err != CL_SUCCESS) {
+      die ("Error: Failed to create compute program!");
+      return err;
+    }
+    err = clBuildProgram (programs[c], 0, NULL, NULL, NULL, NULL);
+    if (err != CL_SUCCESS) {
+      die ("Error: Failed to build program executable for context %d!", c);
+      return err;
+    }
+  }
+
+  for (int p = 0; p < num_parts; p++)
+    total_units += parts[p].units;
+
+  hi = 0;
+  for (int p = 0; p < num_parts; p++) {
+    part *q = &parts[p];
+
+    /* Cells in proportion to the compute units, at least 2 per part.  */
+    lo = hi;
+    units += q->units;
+    hi = (p == num_parts - 1) ? n : (int) ((long) n * units / total_units);
+    if (hi < lo + 2)
+      hi = lo + 2;
+    if (hi > n - 2 * (num_parts - 1 - p))
+      hi = n - 2 * (num_parts - 1 - p);
+    q->first = lo - 1;
+    q->len = hi - lo;
+
+    q->kernel = clCreateKernel (programs[q->ctx], kernel_name, &err);
+    if (!q->kernel || err != CL_SUCCESS) {
+      die ("Error: Failed to create compute kernel for part %d!", p);
+      return err;
+    }
+    q->flag = clCreateBuffer (contexts[q->ctx], CL_MEM_READ_WRITE, sizeof (int),
+                              NULL, &err);
+    for (int b = 0; (b < 2) && (err == CL_SUCCESS); b++)
+      q->buf[b] = clCreateBuffer (contexts[q->ctx], CL_MEM_READ_WRITE,
+                                  sizeof (double) * (q->len + 2), NULL, &err);
+    if (err != CL_SUCCESS) {
+      die ("Error: Failed to allocate device memory for part %d!", p);
+      return err;
+    }
+
+    /* Upload the cells and the halo cells that exist.  */
+    g0 = (lo > 0) ? lo - 1 : 0;
+    g1 = (hi < n) ? hi + 1 : n;
+    for (int b = 0; b < 2; b++) {
+      err = clEnqueueWriteBuffer (q->queue, q->buf[b], CL_TRUE,
+                                  sizeof (double) * (g0 - q->first),
+                                  sizeof (double) * (g1 - g0), v + g0,
+                                  0, NULL, NULL);
+      if (err != CL_SUCCESS) {
+        die ("Error: Failed to write to source array of part %d!", p);
+        return err;
+      }
+    }
+
+    err = clSetKernelArg (q->kernel, 2, sizeof (cl_mem), &q->flag);
+    err |= clSetKernelArg (q->kernel, 3, sizeof (double), &eps);
+    err |= clSetKernelArg (q->kernel, 4, sizeof (int), &q->first);
+    err |= clSetKernelArg (q->kernel, 5, sizeof (unsigned int), &n);
+    if (err != CL_SUCCESS) {
+      die ("Error: Failed to set kernel args of part %d!", p);
+      return err;
+    }
+  }
+  sweeps = 0;
+
+  return err;
+}
+
+cl_int sweepMulti( bool *stable)
+{
+  int s = sweeps % 2;
+  cl_int err = CL_SUCCESS;
+  cl_int fin;
+  size_t global;
+
+  /* Sweep all parts concurrently; read back the flag and the cells the
+     neighbours need as halo.  */
+  for (int p = 0; (p < num_parts) && (err == CL_SUCCESS); p++) {
+    part *q = &parts[p];
+
+    global = q->len;
+    err = clEnqueueWriteBuffer (q->queue, q->flag, CL_FALSE, 0, sizeof (int),
+                                &zero, 0, NULL, NULL);
+    if (err == CL_SUCCESS)
+      err = clSetKernelArg (q->kernel, 0, sizeof (cl_mem), &q->buf[s]);
+    if (err == CL_SUCCESS)
+      err = clSetKernelArg (q->kernel, 1, sizeof (cl_mem), &q->buf[1 - s]);
+    if (err == CL_SUCCESS)
+      err = clEnqueueNDRangeKernel (q->queue, q->kernel, 1, NULL, &global,
+                                    NULL, 0, NULL, NULL);
+    if (err != CL_SUCCESS) {
+      die ("Error: Failed to execute kernel of part %d!", p);
+      break;
+    }
+    err = clEnqueueReadBuffer (q->queue, q->buf[1 - s], CL_FALSE,
+                               sizeof (double), sizeof (double),
+                               &q->edge[s][0], 0, NULL, NULL);
+    if (err == CL_SUCCESS)
+      err = clEnqueueReadBuffer (q->queue, q->buf[1 - s], CL_FALSE,
+                                 sizeof (double) * q->len, sizeof (double),
+                                 &q->edge[s][1], 0, NULL, NULL);
+    if (err == CL_SUCCESS)
+      err = clEnqueueReadBuffer (q->queue, q->flag, CL_FALSE, 0, sizeof (int),
+                                 &q->unstable, 0, NULL, NULL);
+    if (err != CL_SUCCESS)
+      die ("Error: Failed to read back the edges of part %d!", p);
+    clFlush (q->queue);
+  }
+
+  /* Global convergence vote. The flag is zeroed before the sweep, so it only
+     counts once every command of the sweep has succeeded.  */
+  *stable = true;
+  for (int p = 0; p < num_parts; p++) {
+    fin = clFinish (parts[p].queue);
+    if ((fin != CL_SUCCESS) && (err == CL_SUCCESS)) {
+      die ("Error: Failed to finish the sweep of part %d!", p);
+      err = fin;
+    }
+    *stable = *stable && (parts[p].unstable == 0);
+  }
+  if (err != CL_SUCCESS) {
+    *stable = false;
+    return err;
+  }
+
+  /* Halo exchange: the writes are ordered before the next sweep of the
+     part. The edges alternate by parity, so the next sweep of a neighbour
+     cannot overwrite them before they are written.  */
+  for (int p = 0; (p < num_parts) && (err == CL_SUCCESS); p++) {
+    part *q = &parts[p];
+
+    if (p > 0)
+      err = clEnqueueWriteBuffer (q->queue, q->buf[1 - s], CL_FALSE, 0,
+                                  sizeof (double), &parts[p-1].edge[s][1],
+                                  0, NULL, NULL);
+    if ((err == CL_SUCCESS) && (p < num_parts - 1))
+      err = clEnqueueWriteBuffer (q->queue, q->buf[1 - s], CL_FALSE,
+                                  sizeof (double) * (q->len + 1),
+                                  sizeof (double), &parts[p+1].edge[s][0],
+                                  0, NULL, NULL);
+    if (err != CL_SUCCESS)
+      die ("Error: Failed to write the halo cells of part %d!", p);
+    clFlush (q->queue);
+  }
+  sweeps++;
+
+  return err;
+}
+
+void fetchMulti( double *v)
+{
+  int s = sweeps % 2;
+
+  for (int p = 0; p < num_parts; p++) {
+    part *q = &parts[p];
+
+    if (CL_SUCCESS != clEnqueueReadBuffer (q->queue, q->buf[s], CL_TRUE,
+                                           sizeof (double),
+                                           sizeof (double) * q->len,
+                                           v + q->first + 1, 0, NULL, NULL))
+      die ("Error: Failed to transfer part %d from device to host!", p);
+  }
+}
+
+void printMultiInfo()
+{
+  char name[256];
+
+  for (int p = 0; p < num_parts; p++) {
+    name[0] = '\0';
+    clGetDeviceInfo (parts[p].device, CL_DEVICE_NAME, sizeof (name), name, NULL);
+    printf ("part %2d: %s%s, %u compute units, cells %d .. %d\n", p, name,
+            parts[p].sub ? " (NUMA sub-device)" : "", parts[p].units,
+            parts[p].first + 1, parts[p].first + parts[p].len);
+  }
+}
+
+cl_int freeMulti()
+{
+  cl_int err = CL_SUCCESS;
+
+  for (int p = 0; p < num_parts; p++) {
+    part *q = &parts[p];
+
+    if (q->kernel != NULL) {
+      clReleaseKernel (q->kernel);
+      clReleaseMemObject (q->buf[0]);
+      clReleaseMemObject (q->buf[1]);
+      clReleaseMemObject (q->flag);
+    }
+    err = clReleaseCommandQueue (q->queue);
+    if (q->sub)
+      clReleaseDevice (q->device);
+  }
+  num_parts = 0;
+  for (int c = 0; c < num_contexts; c++) {
+    if (programs[c] != NULL)
+      clReleaseProgram (programs[c]);
+    err = clReleaseContext (contexts[c]);
+  }
+  num_contexts = 0;
+
+  return err;
+}
@@ -0,0 +1,76 @@
+#ifndef MULTI_H_
+#define MULTI_H_
+
+#include <stdbool.h>
+#include <CL/cl.h>
+
+/*******************************************************************************
+ *
+ * initMulti : sets up one part of the domain per openCL device: every GPU
+ *             and accelerator of every platform, and the first CPU device
+ *             found (further CPU devices of other platforms are normally
+ *             the same hardware). A CPU device that spans several NUMA
+ *             nodes is split with clCreateSubDevices into one sub-device
+ *             per node, unless the environment variable HEAT_CL_NUMA is
+ *             "0". The parts of a platform share a context; every part gets
+ *             its own command queue.
+ *             Returns the number of parts, 0 if no device was found.
+ *
+ ******************************************************************************/
+extern int initMulti ();
+
+/*******************************************************************************
+ *
+ * setupMulti : builds the kernel "kernel_name" from "kernel_source" in every
+ *              context and distributes the vector "v" of length "n" over
+ *              the parts in proportion to their compute units. Each part
+ *              holds two buffers of its cells plus one halo cell on either
+ *              side. The kernel must have the signature
+ *                (__global double *in, __global double *out,
+ *                 __global int *unstable, const double eps,
+ *                 const int first, const unsigned int n)
+ *              and relax the cells 1 .. get_global_size(0) of "in" into
+ *              "out"; "first" is the global index of cell 0 of the buffers.
+ *              It sets unstable[0] to 1 iff a cell changed by more than
+ *              "eps"; the flag is cleared before every sweep.
+ *
+ ******************************************************************************/
+extern cl_int setupMulti( const char *kernel_source, char *kernel_name,
+                          double *v, int n, double eps);
+
+/*******************************************************************************
+ *
+ * sweepMulti : runs one sweep on all parts concurrently and then exchanges
+ *              the halo cells between neighbouring parts through the host.
+ *              Sets "*stable" to the global convergence vote: true iff no
+ *              part found a cell that changed by more than eps. Returns the
+ *              first error of any command of the sweep; "*stable" is then
+ *              false and the solve has to stop.
+ *
+ ******************************************************************************/
+extern cl_int sweepMulti( bool *stable);
+
+/*******************************************************************************
+ *
+ * fetchMulti : copies the cells of all parts after the last sweep back into
+ *              the vector "v" given to setupMulti.
+ *
+ ******************************************************************************/
+extern void fetchMulti( double *v);
+
+/*******************************************************************************
+ *
+ * printMultiInfo : prints the devices and the cells of every part.
+ *
+ ******************************************************************************/
+extern void printMultiInfo();
+
+/*******************************************************************************
+ *
+ * freeMulti : releases all buffers, kernels, queues, contexts and
+ *             sub-devices.
+ *
+ ******************************************************************************/
+extern cl_int freeMulti();
+
+#endif /* MULTI_H_ */
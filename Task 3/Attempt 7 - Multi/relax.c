@@ -0,0 +1,137 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <math.h>
+#include <time.h>
+
+#include <CL/cl.h>
+#include "multi.h"
+
+#define N 10000000   // length of the vectors
+#define EPS 0.1      // convergence criterium
+#define HEAT 100.0   // heat value on the boundary
+
+struct timespec start, stop;
+
+void printTimeElapsed(char *text)
+{
+  double elapsed = (stop.tv_sec -start.tv_sec)*1000.0
+                  + (double)(stop.tv_nsec -start.tv_nsec)/1000000.0;
+  printf( "%s: %f msec\n", text, elapsed);
+}
+
+//
+// allocate a vector of length "n"
+//
+double *allocVector(int n)
+{
+   double *v;
+   v = (double *)malloc( n*sizeof(double));
+   return v;
+}
+
+//
+// initialise the values of the given vector "out" of length "n"
+//
+void init(double *out, int n)
+{
+   int i;
+
+   for(i=1; i<n; i++) {
+      out[i] = 0;
+   }
+   out[0] = HEAT;
+}
+
+//
+// print the values of a given vector "out" of length "n"
+//
+void print(double *out, int n)
+{
+   int i;
+
+   printf("<");
+   for(i=0; i<n; i++) {
+      printf(" %f", out[i]);
+   }
+   printf(">\n");
+}
+
+//
+//relax function in kernel source: relaxes the cells of one part. Cell j of
+//the part buffers is cell first+j of the rod; cells 0 and len+1 are the
+//halo cells, which hold the neighbouring parts' edge cells.
+//
+const char *KernelSource =                                       "\n"
+  "__kernel void relax(                                          \n"
+  "   __global double* in,                                       \n"
+  "   __global double* out,                                      \n"
+  "   __global int* unstable,                                    \n"
+  "   const double eps,                                          \n"
+  "   const int first,                                           \n"
+  "   const unsigned int n)                                      \n"
+  "{                                                             \n"
+  "   int j = get_global_id(0) + 1;                              \n"
+  "   int g = first + j;                                         \n"
+  "   if (g > 0 && g < n-1) {                                    \n"
+  "      out[j] = 0.25*in[j-1] + 0.5*in[j] + 0.25*in[j+1];       \n"
+  "   } else {                                                   \n"
+  "      out[j] = in[j];                                         \n"
+  "   }                                                          \n"
+  "   if (fabs(in[j] - out[j]) > eps)                            \n"
+  "      unstable[0] = 1;                                        \n"
+  "}                                                             \n"
+  "\n";
+
+int main()
+{
+   cl_int err;
+  
+   double *a;
+   bool stable;
+   int n, parts;
+   int iterations = 0;
+
+   a = allocVector(N);
+
+   init(a, N);
+
+   n = N;
+
+   printf("size   : %d M (%d MB)\n", n/1000000, (int)(n*sizeof(double) / (1024*1024)));
+   printf("heat   : %f\n", HEAT);
+   printf("epsilon: %f\n", EPS);
+   
+   parts = initMulti();
+      
+   if (parts > 0) {
+      err = setupMulti(KernelSource, "relax", a, n, EPS);
+      if (err != CL_SUCCESS) {
+         freeMulti();
+         return 1;
+      }
+      printMultiInfo();
+      printf("\n");
+
+      clock_gettime(1, &start);
+      do {         
+         err = sweepMulti(&stable);
+         iterations++;
+      } while(err == CL_SUCCESS && !stable);
+      if (err != CL_SUCCESS) {
+         printf("sweep %d failed\n", iterations);
+         freeMulti();
+         return 1;
+      }
+      fetchMulti(a);
+      clock_gettime(1, &stop);
+      
+      printf("Number of iterations: %d\n", iterations);
+      printf("Number of parts: %d\n", parts);
+      printTimeElapsed("time spent");
+      
+      err = freeMulti();
+   }
+
+   return 0;
+}
@@ -0,0 +1,327 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "transport.h"
+
+#define N 10000000   // length of the vectors
+#define EPS 0.1      // convergence criterium
+#define HEAT 100.0   // heat value on the boundary
+
+#define RANKS 4      // default number of ranks, see usage()
+#define DEPTH 8      // default halo depth: sweeps between exchanges
+#define TRANSPORT "shm"
+
+struct timespec start, stop;
+
+void printTimeElapsed(char *text)
+{
+  double elapsed = (stop.tv_sec -start.tv_sec)*1000.0
+                  + (double)(stop.tv_nsec -start.tv_nsec)/1000000.0;
+  printf( "%s: %f msec\n", text, elapsed);
+}
+
+void usage(char *name)
+{
+   printf("usage: %s [-p ranks] [-k depth] [-t shm|tcp]   (default -p %d -k %d -t %s)\n",
+          name, RANKS, DEPTH, TRANSPORT);
+}
+
+//
+// allocate a vector of length "n"
+//
+double *allocVector(int n)
+{
+   double *v;
+   v = (double *)malloc( n*sizeof(double));
+   return v;
+}
+
+//
+// print the values of a given vector "out" of length "n"
+//
+void print(double *out, int n)
+{
+   int i;
+
+   printf("<");
+   for(i=0; i<n; i++) {
+      printf(" %f", out[i]);
+   }
+   printf(">\n");
+}
+
+//
+// the part of a rank: it owns the cells lo .. lo+len-1 of the rod of length
+// n, stored with k halo cells on either side, so that local cell j is cell
+// lo-k+j of the rod. Halo cells outside the rod stay 0.
+//
+typedef struct {
+   int n, lo, len, k;
+   double *in, *out, *snap;
+} part;
+
+//
+// initialise the part "p" (including its halos) like init() of the other
+// attempts initialises the whole rod
+//
+void initPart(part *p)
+{
+   int j, g;
+
+   for(j=0; j<p->len + 2*p->k; j++) {
+      g = p->lo - p->k + j;
+      p->in[j] = (g == 0) ? HEAT : 0;
+      p->out[j] = p->in[j];
+   }
+}
+
+//
+// release the vectors of the part "p"
+//
+void freePart(part *p)
+{
+   free(p->in);
+   free(p->out);
+   free(p->snap);
+}
+
+//
+// sweep "t" (0 .. k-1) since the last halo exchange: relaxes every cell
+// whose neighbours are still valid, i.e. all but t+1 cells at either end
+// of the part, with the semantics of the relax kernel. Returns true iff an
+// owned cell changed by more than eps.
+//
+bool sweepPart(part *p, int t)
+{
+   int first = p->lo - p->k;
+   int jlo = t + 1;
+   int jhi = p->len + 2*p->k - 2 - t;
+   bool unstable = false;
+   double *in = p->in, *out = p->out;
+   int j, g;
+
+   if (jlo < -first)
+      jlo = -first;
+   if (jhi > p->n - 1 - first)
+      jhi = p->n - 1 - first;
+   for(j=jlo; j<=jhi; j++) {
+      g = first + j;
+      if (g > 0 && g < p->n-1) {
+         out[j] = 0.25*in[j-1] + 0.5*in[j] + 0.25*in[j+1];
+      } else {
+         out[j] = in[j];
+      }
+      if (j >= p->k && j < p->k + p->len && fabs(in[j] - out[j]) > EPS)
+         unstable = true;
+   }
+   p->in = out;
+   p->out = in;
+   return unstable;
+}
+
+//
+// halo exchange: sends the k owned cells at either end to the neighbours
+// and receives their cells into the halos. Even ranks send before they
+// receive, odd ranks the other way round, so every send meets a matching
+// receive and the exchange cannot deadlock however little the transport
+// buffers.
+//
+int exchange(transport *t, part *p)
+{
+   int k = p->k;
+   int left = t->rank - 1;
+   int right = t->rank + 1;
+   int err = 0;
+
+   if (t->rank % 2 == 0) {
+      if (right < t->size) {
+         err |= t->send(t, right, p->in + p->len, sizeof(double) * k);
+         err |= t->recv(t, right, p->in + k + p->len, sizeof(double) * k);
+      }
+      if (left >= 0) {
+         err |= t->send(t, left, p->in + k, sizeof(double) * k);
+         err |= t->recv(t, left, p->in, sizeof(double) * k);
+      }
+   } else {
+      err |= t->recv(t, left, p->in, sizeof(double) * k);
+      err |= t->send(t, left, p->in + k, sizeof(double) * k);
+      if (right < t->size) {
+         err |= t->recv(t, right, p->in + k + p->len, sizeof(double) * k);
+         err |= t->send(t, right, p->in + p->len, sizeof(double) * k);
+      }
+   }
+   return err;
+}
+
+//
+// the solver of one rank: batches of k sweeps between halo exchanges, with
+// one allreduce of the k stability flags per batch. If the rod became
+// stable within a batch, the part is reset to the start of the batch and
+// relaxed up to the first stable sweep again, so the result is the one of
+// the single-process solver. Rank 0 gathers the rod into "a". Returns the
+// number of sweeps, -1 on a transport error or if any rank (rank 0 also
+// when "a" is NULL) is out of memory: all ranks agree on that before the
+// first exchange, so none of them waits for a rank that has given up.
+//
+int solveRank(transport *t, int n, int k, double *a)
+{
+   part p;
+   int flags[k];
+   int failed[1];
+   int sweeps = 0;
+   int stable = -1;
+   size_t size;
+   int r, s, lo, len;
+
+   p.n = n;
+   p.k = k;
+   p.lo = (int)((long)n * t->rank / t->size);
+   p.len = (int)((long)n * (t->rank + 1) / t->size) - p.lo;
+   size = (p.len + 2*k) * sizeof(double);
+   p.in = allocVector(p.len + 2*k);
+   p.out = allocVector(p.len + 2*k);
+   p.snap = allocVector(p.len + 2*k);
+   failed[0] = (p.in == NULL || p.out == NULL || p.snap == NULL
+                || (t->rank == 0 && a == NULL)) ? 1 : 0;
+   if (allreduceMax(t, failed, 1) != 0 || failed[0] != 0) {
+      freePart(&p);
+      return -1;
+   }
+   initPart(&p);
+
+   while (stable < 0) {
+      if (exchange(t, &p) != 0) {
+         freePart(&p);
+         return -1;
+      }
+      memcpy(p.snap, p.in, size);
+      for(s=0; s<k; s++) {
+         flags[s] = sweepPart(&p, s) ? 1 : 0;
+      }
+      if (allreduceMax(t, flags, k) != 0) {
+         freePart(&p);
+         return -1;
+      }
+      for(s=0; s<k && stable < 0; s++) {
+         if (flags[s] == 0)
+            stable = s;
+      }
+      if (stable >= 0 && stable < k - 1) {
+         memcpy(p.in, p.snap, size);
+         for(s=0; s<=stable; s++) {
+            sweepPart(&p, s);
+         }
+      }
+      sweeps += (stable < 0) ? k : stable + 1;
+   }
+
+   // gather the owned cells at rank 0
+   if (t->rank == 0) {
+      memcpy(a, p.in + k, p.len * sizeof(double));
+      for(r=1; r<t->size; r++) {
+         lo = (int)((long)n * r / t->size);
+         len = (int)((long)n * (r + 1) / t->size) - lo;
+         if (t->recv(t, r, a + lo, len * sizeof(double)) != 0) {
+            freePart(&p);
+            return -1;
+         }
+      }
+   } else if (t->send(t, 0, p.in + k, p.len * sizeof(double)) != 0) {
+      freePart(&p);
+      return -1;
+   }
+
+   freePart(&p);
+   return sweeps;
+}
+
+int main(int argc, char **argv)
+{
+   transport *t;
+   pid_t pids[MAX_RANKS];
+   const char *name = TRANSPORT;
+   double *a = NULL;
+   int ranks = RANKS;
+   int k = DEPTH;
+   int n, r, opt, status;
+   int failed = 0;
+   int iterations = 0;
+
+   while ((opt = getopt(argc, argv, "p:k:t:")) != -1) {
+      switch (opt) {
+         case 'p':
+            ranks = atoi(optarg);
+            break;
+         case 'k':
+            k = atoi(optarg);
+            break;
+         case 't':
+            name = optarg;
+            break;
+         default:
+            usage(argv[0]);
+            return 1;
+      }
+   }
+
+   n = N;
+   if (ranks < 1 || ranks > MAX_RANKS || k < 1 || (long)k * ranks > n) {
+      usage(argv[0]);
+      return 1;
+   }
+
+   printf("size   : %d M (%d MB)\n", n/1000000, (int)(n*sizeof(double) / (1024*1024)));
+   printf("heat   : %f\n", HEAT);
+   printf("epsilon: %f\n", EPS);
+   printf("ranks  : %d over %s, halo depth %d\n", ranks, name, k);
+   fflush(stdout);
+
+   t = openTransport(name, ranks);
+   if (t == NULL)
+      return 1;
+
+   // rank 0 is this process, the others are forked
+   for(r=1; r<ranks; r++) {
+      pids[r] = fork();
+      if (pids[r] == 0) {
+         if (t->attach(t, r) != 0)
+            _exit(1);
+         _exit(solveRank(t, n, k, NULL) < 0 ? 1 : 0);
+      } else if (pids[r] < 0) {
+         printf("cannot fork rank %d\n", r);
+         return 1;
+      }
+   }
+
+   a = allocVector(n);
+   clock_gettime(1, &start);
+   if (t->attach(t, 0) != 0) {
+      iterations = -1;
+   } else {
+      // even without "a", so that the other ranks learn of the failure
+      iterations = solveRank(t, n, k, a);
+   }
+   clock_gettime(1, &stop);
+
+   for(r=1; r<ranks; r++) {
+      if (waitpid(pids[r], &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+         failed++;
+   }
+   t->close(t);
+
+   if (iterations < 0 || failed > 0) {
+      printf("solver failed\n");
+      return 1;
+   }
+   printf("Number of iterations: %d\n", iterations);
+   printTimeElapsed("CPU time spent");
+
+   free(a);
+   return 0;
+}
@@ -0,0 +1,334 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "transport.h"
+
+#define RING_SIZE (64 * 1024)  /* Bytes per ordered pair of ranks.  */
+
+#define die(msg, ...) do {                      \
+  (void) fprintf (stderr, msg, ## __VA_ARGS__); \
+  (void) fprintf (stderr, "\n");                \
+} while (0)
+
+/* shared memory */
+
+/* Single producer, single consumer ring: head and tail only grow; the
+   producer owns head, the consumer owns tail.  */
+typedef struct {
+  size_t head;
+  char   pad1[64 - sizeof (size_t)];
+  size_t tail;
+  char   pad2[64 - sizeof (size_t)];
+  char   data[RING_SIZE];
+} ring;
+
+typedef struct {
+  ring  *rings;                 /* size * size rings, [from][to].  */
+  size_t bytes;
+} shm_state;
+
+static ring *shmRing( transport *t, int from, int to)
+{
+  shm_state *s = (shm_state *) t->state;
+
+  return &s->rings[from * t->size + to];
+}
+
+static int shmAttach( transport *t, int rank)
+{
+  t->rank = rank;
+  return 0;
+}
+
+static int shmSend( transport *t, int to, const void *buf, size_t len)
+{
+  ring *r = shmRing (t, t->rank, to);
+  const char *p = (const char *) buf;
+  size_t head = r->head;
+
+  while (len > 0) {
+    size_t free_bytes = RING_SIZE - (head - __atomic_load_n (&r->tail, __ATOMIC_ACQUIRE));
+    size_t off = head % RING_SIZE;
+    size_t chunk = len;
+
+    if (free_bytes == 0) {
+      sched_yield ();
+      continue;
+    }
+    if (chunk > free_bytes)
+      chunk = free_bytes;
+    if (chunk > RING_SIZE - off)
+      chunk = RING_SIZE - off;
+    memcpy (r->data + off, p, chunk);
+    head += chunk;
+    __atomic_store_n (&r->head, head, __ATOMIC_RELEASE);
+    p += chunk;
+    len -= chunk;
+  }
+  return 0;
+}
+
+static int shmRecv( transport *t, int from, void *buf, size_t len)
+{
+  ring *r = shmRing (t, from, t->rank);
+  char *p = (char *) buf;
+  size_t tail = r->tail;
+
+  while (len > 0) {
+    size_t avail = __atomic_load_n (&r->head, __ATOMIC_ACQUIRE) - tail;
+    size_t off = tail % RING_SIZE;
+    size_t chunk = len;
+
+    if (avail == 0) {
+      sched_yield ();
+      continue;
+    }
+    if (chunk > avail)
+      chunk = avail;
+    if (chunk > RING_SIZE - off)
+      chunk = RING_SIZE - off;
+    memcpy (p, r->data + off, chunk);
+    tail += chunk;
+    __atomic_store_n (&r->tail, tail, __ATOMIC_RELEASE);
+    p += chunk;
+    len -= chunk;
+  }
+  return 0;
+}
+
+static void shmClose( transport *t)
+{
+  shm_state *s = (shm_state *) t->state;
+
+  munmap (s->rings, s->bytes);
+  free (s);
+  free (t);
+}
+
+static transport *openShm( transport *t)
+{
+  shm_state *s = (shm_state *) malloc (sizeof (shm_state));
+
+  if (s == NULL)
+    return NULL;
+  s->bytes = sizeof (ring) * t->size * t->size;
+  /* Anonymous and shared: the forked ranks all see the same rings.  */
+  s->rings = (ring *) mmap (NULL, s->bytes, PROT_READ | PROT_WRITE,
+                            MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (s->rings == MAP_FAILED) {
+    die ("Error: Failed to map %zu bytes of shared memory!", s->bytes);
+    free (s);
+    return NULL;
+  }
+  t->attach = shmAttach;
+  t->send = shmSend;
+  t->recv = shmRecv;
+  t->close = shmClose;
+  t->state = s;
+  return t;
+}
+
+/* tcp loopback */
+
+typedef struct {
+  int listener[MAX_RANKS];      /* Listening socket of every rank.  */
+  int port[MAX_RANKS];
+  int fd[MAX_RANKS];            /* Connection to every other rank.  */
+} tcp_state;
+
+static int tcpAttach( transport *t, int rank)
+{
+  tcp_state *s = (tcp_state *) t->state;
+  struct sockaddr_in addr;
+  int one = 1;
+  int peer, fd;
+
+  t->rank = rank;
+  for (int r = 0; r < t->size; r++) {
+    if (r != rank)
+      close (s->listener[r]);
+    s->fd[r] = -1;
+  }
+
+  /* Connect to the lower ranks: the connection is queued in their backlog
+     even before they accept it, so this cannot deadlock.  */
+  for (int r = 0; r < rank; r++) {
+    fd = socket (AF_INET, SOCK_STREAM, 0);
+    memset (&addr, 0, sizeof (addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+    addr.sin_port = htons (s->port[r]);
+    if (fd < 0 || connect (fd, (struct sockaddr *) &addr, sizeof (addr)) != 0
+         || write (fd, &rank, sizeof (int)) != sizeof (int)) {
+      die ("Error: Rank %d failed to connect to rank %d!", rank, r);
+      return -1;
+    }
+    setsockopt (fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof (one));
+    s->fd[r] = fd;
+  }
+  /* Accept the higher ranks, which identify themselves first.  */
+  for (int r = rank + 1; r < t->size; r++) {
+    fd = accept (s->listener[rank], NULL, NULL);
+    if (fd < 0 || read (fd, &peer, sizeof (int)) != sizeof (int)
+         || peer <= rank || peer >= t->size) {
+      die ("Error: Rank %d failed to accept a connection!", rank);
+      return -1;
+    }
+    setsockopt (fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof (one));
+    s->fd[peer] = fd;
+  }
+  close (s->listener[rank]);
+  return 0;
+}
+
+static int tcpSend( transport *t, int to, const void *buf, size_t len)
+{
+  tcp_state *s = (tcp_state *) t->state;
+  const char *p = (const char *) buf;
+  ssize_t done;
+
+  while (len > 0) {
+    done = write (s->fd[to], p, len);
+    if (done < 0 && errno == EINTR)
+      continue;
+    if (done <= 0) {
+      die ("Error: Rank %d failed to send to rank %d!", t->rank, to);
+      return -1;
+    }
+    p += done;
+    len -= done;
+  }
+  return 0;
+}
+
+static int tcpRecv( transport *t, int from, void *buf, size_t len)
+{
+  tcp_state *s = (tcp_state *) t->state;
+  char *p = (char *) buf;
+  ssize_t done;
+
+  while (len > 0) {
+    done = read (s->fd[from], p, len);
+    if (done < 0 && errno == EINTR)
+      continue;
+    if (done <= 0) {
+      die ("Error: Rank %d failed to receive from rank %d!", t->rank, from);
+      return -1;
+    }
+    p += done;
+    len -= done;
+  }
+  return 0;
+}
+
+static void tcpClose( transport *t)
+{
+  tcp_state *s = (tcp_state *) t->state;
+
+  for (int r = 0; r < t->size; r++)
+    if (s->fd[r] >= 0)
+      close (s->fd[r]);
+  free (s);
+  free (t);
+}
+
+static transport *openTcp( transport *t)
+{
+  tcp_state *s = (tcp_state *) malloc (sizeof (tcp_state));
+  struct sockaddr_in addr;
+  socklen_t len;
+
+  if (s == NULL)
+    return NULL;
+  /* Every rank gets its listening socket before the fork, so all ranks
+     know all ports.  */
+  for (int r = 0; r < t->size; r++) {
+    s->listener[r] = socket (AF_INET, SOCK_STREAM, 0);
+    memset (&addr, 0, sizeof (addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    len = sizeof (addr);
+    if (s->listener[r] < 0
+         || bind (s->listener[r], (struct sockaddr *) &addr, sizeof (addr)) != 0
+         || listen (s->listener[r], MAX_RANKS) != 0
+         || getsockname (s->listener[r], (struct sockaddr *) &addr, &len) != 0) {
+      die ("Error: Failed to listen on 127.0.0.1 for rank %d!", r);
+      for (int q = 0; q <= r; q++)
+        if (s->listener[q] >= 0)
+          close (s->listener[q]);
+      free (s);
+      return NULL;
+    }
+    s->port[r] = ntohs (addr.sin_port);
+  }
+  t->attach = tcpAttach;
+  t->send = tcpSend;
+  t->recv = tcpRecv;
+  t->close = tcpClose;
+  t->state = s;
+  return t;
+}
+
+/* public interface */
+
+transport *openTransport( const char *name, int size)
+{
+  transport *t;
+
+  if (size < 1 || size > MAX_RANKS) {
+    die ("Error: %d ranks are not in 1..%d!", size, MAX_RANKS);
+    return NULL;
+  }
+  t = (transport *) calloc (1, sizeof (transport));
+  if (t == NULL)
+    return NULL;
+  t->size = size;
+
+  if (strcmp (name, "shm") == 0) {
+    t->name = "shm";
+    if (openShm (t) != NULL)
+      return t;
+  } else if (strcmp (name, "tcp") == 0) {
+    t->name = "tcp";
+    if (openTcp (t) != NULL)
+      return t;
+  } else {
+    die ("Error: Unknown transport \"%s\"!", name);
+  }
+  free (t);
+  return NULL;
+}
+
+int allreduceMax( transport *t, int *v, int n)
+{
+  int other[n];
+
+  if (t->rank != 0) {
+    if (t->send (t, 0, v, sizeof (int) * n) != 0)
+      return -1;
+    return t->recv (t, 0, v, sizeof (int) * n);
+  }
+
+  for (int r = 1; r < t->size; r++) {
+    if (t->recv (t, r, other, sizeof (int) * n) != 0)
+      return -1;
+    for (int i = 0; i < n; i++)
+      if (other[i] > v[i])
+        v[i] = other[i];
+  }
+  for (int r = 1; r < t->size; r++)
+    if (t->send (t, r, v, sizeof (int) * n) != 0)
+      return -1;
+  return 0;
+}
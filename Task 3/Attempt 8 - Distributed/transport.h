@@ -0,0 +1,52 @@
+#ifndef TRANSPORT_H_
+#define TRANSPORT_H_
+
+#include <stddef.h>
+
+#define MAX_RANKS 16
+
+/*******************************************************************************
+ *
+ * transport : point to point messages between "size" ranks. A transport is
+ *             opened once before the ranks are forked and attached by every
+ *             rank afterwards. send and recv block until "len" bytes have
+ *             been handed over; messages between two ranks arrive in the
+ *             order they were sent. All functions return 0 on success.
+ *
+ ******************************************************************************/
+typedef struct transport transport;
+
+struct transport {
+  const char *name;
+  int   rank;
+  int   size;
+  int  (*attach) (transport *t, int rank);
+  int  (*send) (transport *t, int to, const void *buf, size_t len);
+  int  (*recv) (transport *t, int from, void *buf, size_t len);
+  void (*close) (transport *t);
+  void *state;
+};
+
+/*******************************************************************************
+ *
+ * openTransport : opens the transport "name" for "size" ranks (at most
+ *                 MAX_RANKS):
+ *                - "shm" : one ring buffer per ordered pair of ranks in a
+ *                          shared anonymous mapping
+ *                - "tcp" : a full mesh of TCP connections over 127.0.0.1
+ *                Returns NULL if the name is unknown or the setup fails.
+ *
+ ******************************************************************************/
+extern transport *openTransport( const char *name, int size);
+
+/*******************************************************************************
+ *
+ * allreduceMax : replaces the "n" ints "v" on every rank by the element-wise
+ *                maximum over all ranks. Every rank must call it with the
+ *                same "n". Rank 0 combines the values and sends the result
+ *                back.
+ *
+ ******************************************************************************/
+extern int allreduceMax( transport *t, int *v, int n);
+
+#endif /* TRANSPORT_H_ */